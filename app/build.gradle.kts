@@ -122,7 +122,11 @@ tasks.register("copyFiles") {
 
         soDir.walk().filter { it.isFile && it.extension == "so" }.forEach { soFile ->
             val abiFolder = soFile.parentFile.name
-            val destination = moduleFolder.resolve("zygisk/$abiFolder.so")
+            val destination = if (soFile.name == "libpifhook.so") {
+                moduleFolder.resolve("lib/$abiFolder/libpifhook.so")
+            } else {
+                moduleFolder.resolve("zygisk/$abiFolder.so")
+            }
             soFile.copyTo(destination, overwrite = true)
         }
     }
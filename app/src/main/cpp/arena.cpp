@@ -0,0 +1,42 @@
+#include <sys/mman.h>
+#include "arena.hpp"
+
+void *Arena::allocate(size_t size, size_t align) {
+    if (!base) {
+        void *map = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (map == MAP_FAILED) return nullptr;
+        base = static_cast<uint8_t *>(map);
+    }
+
+    size_t offset = (used + align - 1) & ~(align - 1);
+
+    if (offset > capacity || size > capacity - offset) return nullptr;
+
+    last = base + offset;
+    used = offset + size;
+    if (used > peakUsed) peakUsed = used;
+
+    return last;
+}
+
+void *Arena::resize(void *ptr, size_t size) {
+    if (!ptr || ptr != last) return nullptr;
+
+    size_t offset = last - base;
+
+    if (size > capacity - offset) return nullptr;
+
+    used = offset + size;
+    if (used > peakUsed) peakUsed = used;
+
+    return ptr;
+}
+
+void Arena::release() {
+    if (base) munmap(base, capacity);
+
+    base = nullptr;
+    last = nullptr;
+    used = 0;
+}
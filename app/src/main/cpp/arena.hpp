@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bump-pointer arena over one anonymous mapping. The address space is reserved up front and
+// pages only cost memory once touched, everything is freed together by release().
+class Arena {
+public:
+    explicit Arena(size_t capacity) : capacity(capacity) {}
+
+    ~Arena() {
+        release();
+    }
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    // nullptr when the arena is exhausted or can't be mapped
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    // Grows or shrinks ptr in place, which only works for the latest allocation
+    void *resize(void *ptr, size_t size);
+
+    void release();
+
+    // Highest number of bytes in use since the arena was created
+    size_t peak() const {
+        return peakUsed;
+    }
+
+private:
+    size_t capacity;
+    uint8_t *base = nullptr;
+    size_t used = 0;
+    size_t peakUsed = 0;
+    uint8_t *last = nullptr;
+};
@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "config.hpp"
+
+static const char PIF_JSON[] = R"({
+  "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+  "MANUFACTURER": "Google",
+  "MODEL": "Pixel 6",
+  "SECURITY_PATCH": "2025-04-05",
+  "PROPS": {"ro.boot.flash.locked": "1", "ro.boot.vbmeta.device_state": "locked"}
+})";
+
+// What the companion pays once per pif.json change
+static void BM_CompileConfig(benchmark::State &state) {
+    std::string json;
+
+    for (auto _: state) {
+        json = PIF_JSON;
+        ConfigDiagnostics diagnostics;
+        auto record = compileConfig(std::span(json.data(), json.size()), diagnostics);
+        benchmark::DoNotOptimize(record.data());
+    }
+}
+
+BENCHMARK(BM_CompileConfig);
+
+// What every process pays on the module side
+static void BM_ParseConfig(benchmark::State &state) {
+    std::string json = PIF_JSON;
+    ConfigDiagnostics diagnostics;
+    auto record = compileConfig(std::span(json.data(), json.size()), diagnostics);
+
+    for (auto _: state) {
+        ConfigView config;
+        benchmark::DoNotOptimize(parseConfig(record, config));
+        size_t fields = 0;
+        forEachConfigField(config, [&](const BuildField &, const char *value) {
+            fields += value[0] != 0;
+        });
+        benchmark::DoNotOptimize(fields);
+    }
+}
+
+BENCHMARK(BM_ParseConfig);
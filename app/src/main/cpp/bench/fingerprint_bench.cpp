@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+#include <ranges>
+#include <string>
+#include <vector>
+#include "fingerprint.hpp"
+
+static const std::string FINGERPRINT =
+        "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys";
+
+static void BM_SplitFingerprint(benchmark::State &state) {
+    for (auto _: state) {
+        FingerprintParts parts;
+        benchmark::DoNotOptimize(splitFingerprint(FINGERPRINT, parts));
+        benchmark::DoNotOptimize(parts.data());
+    }
+}
+
+BENCHMARK(BM_SplitFingerprint);
+
+// The splitter before, nested views::split and a std::string per part, without validation
+static std::vector<std::string> splitFingerprintCopying(std::string_view fingerprint) {
+    std::vector<std::string> vector;
+    auto parts = fingerprint | std::views::split('/');
+
+    for (const auto &part: parts) {
+        auto subParts = std::string(part.begin(), part.end()) | std::views::split(':');
+        for (const auto &subPart: subParts) {
+            vector.emplace_back(subPart.begin(), subPart.end());
+        }
+    }
+
+    return vector;
+}
+
+static void BM_SplitFingerprintCopying(benchmark::State &state) {
+    for (auto _: state) {
+        auto parts = splitFingerprintCopying(FINGERPRINT);
+        benchmark::DoNotOptimize(parts.data());
+    }
+}
+
+BENCHMARK(BM_SplitFingerprintCopying);
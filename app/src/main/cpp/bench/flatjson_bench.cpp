@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "flatjson.hpp"
+#include "json.hpp"
+
+// json.hpp is the nlohmann::json the companion used before, kept here only to compare against
+
+static const char MODULE_PIF_JSON[] = R"({
+  "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+  "MANUFACTURER": "Google",
+  "MODEL": "Pixel 6",
+  "SECURITY_PATCH": "2025-04-05"
+})";
+
+// Shaped like the custom.pif.json people share, with comments, flags and PROPS
+static const char CUSTOM_PIF_JSON[] = R"({
+  // Pixel 6 beta
+  "ID": "BP22.250325.012",
+  "BRAND": "google",
+  "DEVICE": "oriole",
+  "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+  "MANUFACTURER": "Google",
+  "MODEL": "Pixel 6",
+  "PRODUCT": "oriole_beta",
+  "SECURITY_PATCH": "2025-04-05",
+  "DEVICE_INITIAL_SDK_INT": 32,
+  "spoofProvider": true,
+  "spoofProps": true,
+  "spoofSignature": false,
+  "DEBUG": false,
+  /* Reported instead of the real values */
+  "PROPS": {
+    "ro.boot.flash.locked": "1",
+    "ro.boot.vbmeta.device_state": "locked",
+    "ro.boot.verifiedbootstate": "green",
+    "ro.build.tags": "release-keys",
+    "ro.build.type": "user",
+    "*.security_patch": "2025-04-05",
+    "*api_level": "32",
+    "ro.debuggable": "0",
+    "ro.secure": "1"
+  }
+})";
+
+static void BM_ParsePifJsonFlat(benchmark::State &state, const char *text) {
+    std::string source = text;
+    std::vector<char> buffer(source.size());
+
+    for (auto _: state) {
+        // Parsing decodes in place, start from the pristine text every time
+        std::copy(source.begin(), source.end(), buffer.begin());
+        PifJson json;
+        benchmark::DoNotOptimize(parsePifJson(buffer, json));
+        benchmark::DoNotOptimize(json.fields.size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+// The old compileConfig(): a DOM with comments allowed, then every string value read out
+static void BM_ParsePifJsonNlohmann(benchmark::State &state, const char *text) {
+    std::string source = text;
+    std::vector<char> buffer(source.size());
+
+    for (auto _: state) {
+        std::copy(source.begin(), source.end(), buffer.begin());
+        auto json = nlohmann::json::parse(buffer, nullptr, false, true);
+        size_t strings = 0;
+        for (auto &[key, value]: json.items()) {
+            if (value.is_string()) strings += value.get<std::string>().size();
+        }
+        benchmark::DoNotOptimize(strings);
+    }
+
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+BENCHMARK_CAPTURE(BM_ParsePifJsonFlat, module, MODULE_PIF_JSON);
+BENCHMARK_CAPTURE(BM_ParsePifJsonNlohmann, module, MODULE_PIF_JSON);
+BENCHMARK_CAPTURE(BM_ParsePifJsonFlat, custom, CUSTOM_PIF_JSON);
+BENCHMARK_CAPTURE(BM_ParsePifJsonNlohmann, custom, CUSTOM_PIF_JSON);
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <vector>
+#include "hook.hpp"
+
+// One property read through the hook, with a fake __system_property_read_callback that
+// only calls back, so what's measured is the hook's own overhead
+struct FakeProp {
+    const char *name;
+    const char *value;
+    uint32_t serial;
+};
+
+static void fakeReadCallback(const prop_info *pi, T_Callback callback, void *cookie) {
+    auto *prop = reinterpret_cast<const FakeProp *>(pi);
+    callback(cookie, prop->name, prop->value, prop->serial);
+}
+
+static void countRead(void *cookie, const char *, const char *value, uint32_t) {
+    *static_cast<size_t *>(cookie) += value[0];
+}
+
+static FakeProp PROPS[] = {
+        {"ro.build.version.security_patch", "2020-01-01", 2},
+        {"ro.product.first_api_level", "29", 2},
+        {"ro.hardware", "oriole", 2},
+        {"persist.sys.locale", "en-US", 2},
+};
+
+static HookState *setUpHook(bool withStats) {
+    static PropStats stats;
+    HookState *state = pifHookState();
+
+    PropRuleSource rules[] = {{"*.security_patch", "2025-04-05"}, {"*api_level", "32"}};
+    static std::vector<uint8_t> matcher = buildPropMatcher(rules);
+    state->props = matcher.data();
+    state->propsSize = matcher.size();
+    state->original = fakeReadCallback;
+    state->stats = withStats ? &stats : nullptr;
+    return state;
+}
+
+static void BM_HookRead(benchmark::State &state) {
+    static HookState *hook;
+    if (state.thread_index() == 0) hook = setUpHook(state.range(0));
+
+    size_t sum = 0;
+    size_t i = state.thread_index();
+
+    for (auto _: state) {
+        hook->replacement(reinterpret_cast<const prop_info *>(&PROPS[i++ % std::size(PROPS)]),
+                          countRead, &sum);
+    }
+
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Without and with the shared stats region, up to eight threads reading at once
+BENCHMARK(BM_HookRead)->ArgName("stats")->Arg(0)->Arg(1)->ThreadRange(1, 8);
+
+static void BM_DirectRead(benchmark::State &state) {
+    size_t sum = 0;
+    size_t i = 0;
+
+    for (auto _: state) {
+        fakeReadCallback(reinterpret_cast<const prop_info *>(&PROPS[i++ % std::size(PROPS)]),
+                         countRead, &sum);
+    }
+
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_DirectRead);
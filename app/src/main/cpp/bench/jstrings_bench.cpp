@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "fakejni.hpp"
+#include "jstrings.hpp"
+
+// The fake env converts on every call like ART does, but its costs aren't ART's, so only the
+// difference between the two paths means something
+static FakeString appDataDir{u"/data/user/0/com.example.someapp.with.a.longer.package.name"};
+static FakeString niceName{u"com.example.someapp.with.a.longer.package.name"};
+
+static void BM_JStringTail(benchmark::State &state) {
+    FakeEnv env;
+
+    for (auto _: state) {
+        bool isGms = jstringEndsWith(&env, &appDataDir, "/com.google.android.gms");
+        benchmark::DoNotOptimize(isGms);
+    }
+}
+
+BENCHMARK(BM_JStringTail);
+
+// What preAppSpecialize did before, both strings copied out for every app
+static void BM_JStringCopy(benchmark::State &state) {
+    FakeEnv env;
+
+    for (auto _: state) {
+        std::string dir, name;
+
+        auto rawDir = env.GetStringUTFChars(&appDataDir, nullptr);
+        if (rawDir) {
+            dir = rawDir;
+            env.ReleaseStringUTFChars(&appDataDir, rawDir);
+        }
+
+        auto rawName = env.GetStringUTFChars(&niceName, nullptr);
+        if (rawName) {
+            name = rawName;
+            env.ReleaseStringUTFChars(&niceName, rawName);
+        }
+
+        bool isGms = dir.ends_with("/com.google.android.gms");
+        benchmark::DoNotOptimize(isGms);
+        benchmark::DoNotOptimize(name.data());
+    }
+}
+
+BENCHMARK(BM_JStringCopy);
@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <memory>
+#include "logonce.hpp"
+
+// A repeat, which is what nearly every hooked read that logs ends up being
+static void BM_LogOnceRepeat(benchmark::State &state) {
+    static LogOnce *log;
+    if (state.thread_index() == 0) {
+        static auto owner = std::make_unique<LogOnce>();
+        log = owner.get();
+        // The first time goes to stderr, keep it out of the results
+        FILE *saved = stderr;
+        stderr = fopen("/dev/null", "w");
+        log->log("[%s]: %s -> %s", "ro.build.version.security_patch", "2020-01-01", "2025-04-05");
+        fclose(stderr);
+        stderr = saved;
+    }
+
+    for (auto _: state) {
+        log->log("[%s]: %s -> %s", "ro.build.version.security_patch", "2020-01-01", "2025-04-05");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_LogOnceRepeat)->ThreadRange(1, 8);
+
+// Formatting and writing every time, as the hook did before, to /dev/null instead of logd
+static void BM_LogEveryTime(benchmark::State &state) {
+    FILE *devNull = fopen("/dev/null", "w");
+
+    for (auto _: state) {
+        fprintf(devNull, "D PIF: [%s]: %s -> %s\n", "ro.build.version.security_patch",
+                "2020-01-01", "2025-04-05");
+        fflush(devNull);
+    }
+
+    fclose(devNull);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_LogEveryTime);
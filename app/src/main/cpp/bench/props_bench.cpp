@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "props.hpp"
+
+#define SDK "32"
+#define SECURITY_PATCH "2025-04-05"
+#define BUILD_ID "BP22.250325.012"
+
+static const std::vector<std::string> &propTrace() {
+    static std::vector<std::string> trace = [] {
+        std::vector<std::string> names;
+        std::ifstream file(PIF_BENCH_DATA_DIR "/gms_props.txt");
+        for (std::string line; std::getline(file, line);) {
+            if (!line.empty() && line[0] != '#') names.push_back(line);
+        }
+        return names;
+    }();
+    return trace;
+}
+
+// The if/else chain in modify_callback before the rule table
+[[gnu::noinline]] static const char *chainOverride(std::string_view name, const char *value) {
+    if (name == "init.svc.adbd") value = "stopped";
+    else if (name == "sys.usb.state") value = "mtp";
+    else if (name.ends_with("api_level")) value = SDK;
+    else if (name.ends_with(".security_patch")) value = SECURITY_PATCH;
+    else if (name.ends_with(".build.id")) value = BUILD_ID;
+    return value;
+}
+
+static void BM_PropTraceChain(benchmark::State &state) {
+    auto &trace = propTrace();
+    const char *value = "unchanged";
+
+    for (auto _: state) {
+        size_t spoofed = 0;
+        for (auto &name: trace) {
+            const char *newValue = chainOverride(name, value);
+            spoofed += strcmp(value, newValue) != 0;
+        }
+        benchmark::DoNotOptimize(spoofed);
+    }
+
+    state.SetItemsProcessed(state.iterations() * trace.size());
+}
+
+BENCHMARK(BM_PropTraceChain);
+
+// The same rules as the chain
+static std::vector<uint8_t> defaultMatcher() {
+    std::vector<PropRuleSource> rules(std::begin(PROP_FIXED_RULES), std::end(PROP_FIXED_RULES));
+    rules.push_back({PROP_SDK_PATTERN, SDK});
+    rules.push_back({PROP_SECURITY_PATCH_PATTERN, SECURITY_PATCH});
+    rules.push_back({PROP_BUILD_ID_PATTERN, BUILD_ID});
+
+    auto matcher = buildPropMatcher(rules);
+    if (!parsePropMatcher(matcher)) matcher.clear();
+    return matcher;
+}
+
+// The default rules are all exact names and suffixes, so every lookup is one tail table probe
+static void BM_PropTraceMatcher(benchmark::State &state) {
+    auto &trace = propTrace();
+    const char *value = "unchanged";
+
+    auto matcher = defaultMatcher();
+    if (matcher.empty()) {
+        state.SkipWithError("buildPropMatcher failed");
+        return;
+    }
+
+    for (auto _: state) {
+        size_t spoofed = 0;
+        for (auto &name: trace) {
+            int32_t offset = findPropValue(matcher, name);
+            spoofed += offset >= 0 && strcmp(value, propValue(matcher, offset)) != 0;
+        }
+        benchmark::DoNotOptimize(spoofed);
+    }
+
+    state.SetItemsProcessed(state.iterations() * trace.size());
+}
+
+BENCHMARK(BM_PropTraceMatcher);
+
+// Lookup cost as PROPS grows, half exact names and half suffixes on top of the default rules.
+// The names looked up are the first ten of the trace. Up to 100 or so rules still fit in the
+// tail table, past that lookups fall back to the exact table and the tries.
+static void BM_PropMatcherScaling(benchmark::State &state) {
+    auto &trace = propTrace();
+    auto extra = static_cast<int>(state.range(0));
+
+    std::vector<std::string> patterns;
+    for (int i = 0; i < extra / 2; ++i) patterns.push_back("vendor.rule" + std::to_string(i));
+    for (int i = 0; i < extra / 2; ++i) patterns.push_back("*.suffix" + std::to_string(i));
+
+    std::vector<PropRuleSource> rules(std::begin(PROP_FIXED_RULES), std::end(PROP_FIXED_RULES));
+    rules.push_back({PROP_SDK_PATTERN, SDK});
+    rules.push_back({PROP_SECURITY_PATCH_PATTERN, SECURITY_PATCH});
+    rules.push_back({PROP_BUILD_ID_PATTERN, BUILD_ID});
+    for (auto &pattern: patterns) rules.push_back({pattern, "v"});
+
+    auto matcher = buildPropMatcher(rules);
+    if (matcher.empty()) {
+        state.SkipWithError("Too many rules for PROP_MATCHER_MAX");
+        return;
+    }
+
+    for (auto _: state) {
+        for (size_t i = 0; i < 10; ++i) benchmark::DoNotOptimize(findPropValue(matcher, trace[i]));
+    }
+
+    state.SetItemsProcessed(state.iterations() * 10);
+    state.counters["bytes"] = static_cast<double>(matcher.size());
+}
+
+BENCHMARK(BM_PropMatcherScaling)->Arg(0)->Arg(100)->Arg(400)->Arg(1000);
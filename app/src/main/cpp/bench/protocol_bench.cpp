@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+#include "protocol.hpp"
+
+// Request and reply over a socket pair, the way a launching app talks to the companion
+static void BM_ProtocolRoundTrip(benchmark::State &state) {
+    int sockets[2];
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets);
+
+    std::vector<uint8_t> config(state.range(0), 0x5A);
+    int64_t rounds = state.max_iterations;
+
+    std::thread companion([&] {
+        std::vector<uint8_t> buffer;
+        CompanionMessage message;
+        message.config = config;
+
+        for (int64_t i = 0; i < rounds; ++i) {
+            ModuleRequest request;
+            if (!recvRequest(sockets[1], buffer, request, deadlineAfterMs(1000))) break;
+            if (!sendMessage(sockets[1], {}, message, deadlineAfterMs(1000))) break;
+        }
+    });
+
+    Arena arena(1 << 20);
+    ModuleRequest request;
+    request.request = REQUEST_CONFIG;
+
+    for (auto _: state) {
+        CompanionMessage message;
+        CompanionFds fds;
+        sendRequest(sockets[0], request, deadlineAfterMs(1000));
+        if (!recvMessage(sockets[0], arena, message, fds, deadlineAfterMs(1000))) {
+            state.SkipWithError("recvMessage failed");
+            break;
+        }
+        benchmark::DoNotOptimize(message.config.data());
+        arena.release();
+    }
+
+    shutdown(sockets[0], SHUT_RDWR);
+    companion.join();
+    close(sockets[0]);
+    close(sockets[1]);
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ProtocolRoundTrip)->Arg(512)->Arg(4096)->Arg(64 << 10)->UseRealTime();
@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+#include <dlfcn.h>
+#include "symbols.hpp"
+
+// What every process paid before the companion sent the offset
+static void BM_FindLibcSymbol(benchmark::State &state) {
+    for (auto _: state) benchmark::DoNotOptimize(findLibcSymbol("getpid"));
+}
+
+BENCHMARK(BM_FindLibcSymbol);
+
+static void BM_DlsymDefault(benchmark::State &state) {
+    for (auto _: state) benchmark::DoNotOptimize(dlsym(RTLD_DEFAULT, "getpid"));
+}
+
+BENCHMARK(BM_DlsymDefault);
+
+// What a process does with the offset the companion resolved
+static void BM_LibcSymbolAddress(benchmark::State &state) {
+    LibcSymbol symbol;
+    if (!resolveLibcSymbol("getpid", symbol)) {
+        state.SkipWithError("libc has no build ID");
+        return;
+    }
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(
+                libcSymbolAddress({symbol.buildId, symbol.buildIdSize}, symbol.offset));
+    }
+}
+
+BENCHMARK(BM_LibcSymbolAddress);
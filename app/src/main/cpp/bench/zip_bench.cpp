@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "zip.hpp"
+#include "ziparchive.hpp"
+
+// Shaped like /system/etc/security/otacerts.zip, one PEM certificate or a few
+static std::vector<uint8_t> otaCerts(size_t certificates) {
+    std::vector<ZipEntryInfo> entries;
+    for (size_t i = 0; i < certificates; ++i)
+        entries.push_back({"releasekey" + std::to_string(i) + ".x509.pem", 1500});
+    entries.push_back({"testkey.x509.pem", 1500});
+    return buildZip(entries);
+}
+
+static void BM_ZipScan(benchmark::State &state) {
+    auto zip = otaCerts(state.range(0));
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(zipHasEntryContaining(zip.data(), zip.size(), "test"));
+    }
+}
+
+BENCHMARK(BM_ZipScan)->Arg(0)->Arg(4)->Arg(64);
+
+// What checkOtaZip() did before, a shell running unzip -l on the file
+static void BM_ZipUnzipList(benchmark::State &state) {
+    if (system("command -v unzip >/dev/null 2>&1") != 0) {
+        state.SkipWithError("unzip isn't installed");
+        return;
+    }
+
+    auto zip = otaCerts(state.range(0));
+    char path[] = "/tmp/pif_otacerts_XXXXXX";
+    int fd = mkstemp(path);
+    write(fd, zip.data(), zip.size());
+    close(fd);
+
+    std::string command = std::string("unzip -l ") + path;
+
+    for (auto _: state) {
+        std::array<char, 256> buffer{};
+        std::string result;
+        bool found = false;
+
+        std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
+        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
+            result += buffer.data();
+            if (result.find("test") != std::string::npos) {
+                found = true;
+                break;
+            }
+        }
+
+        benchmark::DoNotOptimize(found);
+    }
+
+    unlink(path);
+}
+
+BENCHMARK(BM_ZipUnzipList)->Arg(0)->Arg(4)->Arg(64)->UseRealTime();
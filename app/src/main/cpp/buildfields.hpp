@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum BuildClass : uint8_t {
+    BUILD_CLASS_BUILD,
+    BUILD_CLASS_VERSION,
+};
+
+struct BuildField {
+    const char *name;
+    BuildClass owner;
+    const char *signature;
+};
+
+#define JNI_STRING "Ljava/lang/String;"
+
+// Every static String field of android.os.Build and android.os.Build.VERSION pif.json may set.
+// Fields added in later SDKs are still listed, the module skips them when they don't exist.
+inline constexpr BuildField BUILD_FIELDS[] = {
+        {"ID",                         BUILD_CLASS_BUILD,   JNI_STRING},
+        {"DISPLAY",                    BUILD_CLASS_BUILD,   JNI_STRING},
+        {"PRODUCT",                    BUILD_CLASS_BUILD,   JNI_STRING},
+        {"DEVICE",                     BUILD_CLASS_BUILD,   JNI_STRING},
+        {"BOARD",                      BUILD_CLASS_BUILD,   JNI_STRING},
+        {"CPU_ABI",                    BUILD_CLASS_BUILD,   JNI_STRING},
+        {"CPU_ABI2",                   BUILD_CLASS_BUILD,   JNI_STRING},
+        {"MANUFACTURER",               BUILD_CLASS_BUILD,   JNI_STRING},
+        {"BRAND",                      BUILD_CLASS_BUILD,   JNI_STRING},
+        {"MODEL",                      BUILD_CLASS_BUILD,   JNI_STRING},
+        {"SOC_MANUFACTURER",           BUILD_CLASS_BUILD,   JNI_STRING},
+        {"SOC_MODEL",                  BUILD_CLASS_BUILD,   JNI_STRING},
+        {"SKU",                        BUILD_CLASS_BUILD,   JNI_STRING},
+        {"ODM_SKU",                    BUILD_CLASS_BUILD,   JNI_STRING},
+        {"BOOTLOADER",                 BUILD_CLASS_BUILD,   JNI_STRING},
+        {"RADIO",                      BUILD_CLASS_BUILD,   JNI_STRING},
+        {"HARDWARE",                   BUILD_CLASS_BUILD,   JNI_STRING},
+        {"SERIAL",                     BUILD_CLASS_BUILD,   JNI_STRING},
+        {"TYPE",                       BUILD_CLASS_BUILD,   JNI_STRING},
+        {"TAGS",                       BUILD_CLASS_BUILD,   JNI_STRING},
+        {"FINGERPRINT",                BUILD_CLASS_BUILD,   JNI_STRING},
+        {"USER",                       BUILD_CLASS_BUILD,   JNI_STRING},
+        {"HOST",                       BUILD_CLASS_BUILD,   JNI_STRING},
+        {"INCREMENTAL",                BUILD_CLASS_VERSION, JNI_STRING},
+        {"RELEASE",                    BUILD_CLASS_VERSION, JNI_STRING},
+        {"RELEASE_OR_CODENAME",        BUILD_CLASS_VERSION, JNI_STRING},
+        {"RELEASE_OR_PREVIEW_DISPLAY", BUILD_CLASS_VERSION, JNI_STRING},
+        {"BASE_OS",                    BUILD_CLASS_VERSION, JNI_STRING},
+        {"SECURITY_PATCH",             BUILD_CLASS_VERSION, JNI_STRING},
+        {"SDK",                        BUILD_CLASS_VERSION, JNI_STRING},
+        {"CODENAME",                   BUILD_CLASS_VERSION, JNI_STRING},
+        {"PREVIEW_SDK_FINGERPRINT",    BUILD_CLASS_VERSION, JNI_STRING},
+};
+
+#undef JNI_STRING
+
+inline constexpr size_t BUILD_FIELD_COUNT = std::size(BUILD_FIELDS);
+
+#define BUILD_FIELD_SLOTS 128
+
+constexpr uint32_t buildFieldHash(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c: name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+struct BuildFieldIndex {
+    uint32_t seed = 0;
+    std::array<uint8_t, BUILD_FIELD_SLOTS> slots{};
+};
+
+// Searches for a seed under which no two field names share a slot
+consteval BuildFieldIndex makeBuildFieldIndex() {
+    for (uint32_t seed = 0; seed < 10000; ++seed) {
+        BuildFieldIndex index{seed};
+        index.slots.fill(UINT8_MAX);
+
+        bool collision = false;
+        for (size_t i = 0; i < BUILD_FIELD_COUNT && !collision; ++i) {
+            auto &slot = index.slots[buildFieldHash(BUILD_FIELDS[i].name, seed) % BUILD_FIELD_SLOTS];
+            collision = slot != UINT8_MAX;
+            slot = i;
+        }
+
+        if (!collision) return index;
+    }
+    return {UINT32_MAX};
+}
+
+inline constexpr BuildFieldIndex BUILD_FIELD_INDEX = makeBuildFieldIndex();
+
+static_assert(BUILD_FIELD_COUNT < UINT8_MAX && BUILD_FIELD_COUNT <= BUILD_FIELD_SLOTS);
+static_assert(BUILD_FIELD_INDEX.seed != UINT32_MAX, "No perfect hash for BUILD_FIELDS");
+
+// Index into BUILD_FIELDS, or -1 when name isn't a supported Build field
+constexpr int findBuildField(std::string_view name) {
+    uint8_t i = BUILD_FIELD_INDEX.slots[buildFieldHash(name, BUILD_FIELD_INDEX.seed) % BUILD_FIELD_SLOTS];
+    if (i == UINT8_MAX || BUILD_FIELDS[i].name != name) return -1;
+    return i;
+}
+
+static_assert(findBuildField("SECURITY_PATCH") == 28 && findBuildField("ID") == 0);
+static_assert(findBuildField("spoofVendingSdk") == -1 && findBuildField("") == -1);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// A single unaligned load or store, the hook reads its matcher through these
+template<typename T>
+inline T readLE(const uint8_t *ptr) {
+    T value;
+    memcpy(&value, ptr, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    return value;
+}
+
+template<typename T>
+inline void writeLE(uint8_t *ptr, T value) {
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    memcpy(ptr, &value, sizeof(value));
+}
@@ -0,0 +1,340 @@
+#include <cstdarg>
+#include <cstdio>
+#include <utility>
+#include "config.hpp"
+#include "fingerprint.hpp"
+#include "flatjson.hpp"
+#include "log.hpp"
+#include "props.hpp"
+#include "stringpool.hpp"
+
+bool parseConfig(std::span<const uint8_t> data, ConfigView &config) {
+    const uint8_t *ptr = data.data();
+
+    if (data.size() < CONFIG_HEADER_SIZE + CONFIG_STRING_COUNT * 4) return false;
+
+    if (readLE<uint32_t>(ptr) != CONFIG_MAGIC || readLE<uint16_t>(ptr + 4) != CONFIG_VERSION)
+        return false;
+
+    config.fieldCount = readLE<uint16_t>(ptr + 6);
+    config.flags = readLE<uint32_t>(ptr + 8);
+    uint32_t poolSize = readLE<uint32_t>(ptr + 12);
+    uint32_t status = readLE<uint32_t>(ptr + 16);
+    uint32_t propsSize = readLE<uint32_t>(ptr + 20);
+
+    if (status > CONFIG_STATUS_ERRORS || propsSize > PROP_MATCHER_MAX) return false;
+    config.status = static_cast<ConfigStatus>(status);
+
+    size_t fieldsOffset = CONFIG_HEADER_SIZE + CONFIG_STRING_COUNT * 4;
+    size_t propsOffset = fieldsOffset + config.fieldCount * CONFIG_FIELD_SIZE;
+    size_t poolOffset = propsOffset + ((propsSize + 3) & ~3u);
+
+    if (poolSize == 0 || data.size() != poolOffset + poolSize || data.back() != 0) return false;
+
+    config.fields = ptr + fieldsOffset;
+    config.props = data.subspan(propsOffset, propsSize);
+    config.pool = reinterpret_cast<const char *>(ptr + poolOffset);
+
+    if (!parsePropMatcher(config.props)) return false;
+
+    uint32_t javaJson = readLE<uint32_t>(ptr + CONFIG_HEADER_SIZE);
+    if (javaJson >= poolSize) return false;
+    config.javaJson = config.pool + javaJson;
+
+    for (uint16_t i = 0; i < config.fieldCount; ++i) {
+        const uint8_t *field = config.fields + i * CONFIG_FIELD_SIZE;
+        if (readLE<uint32_t>(field) >= poolSize || field[4] >= BUILD_FIELD_COUNT) return false;
+    }
+
+    return true;
+}
+
+const char *configStatusName(ConfigStatus status) {
+    switch (status) {
+        case CONFIG_STATUS_OK:
+            return "ok";
+        case CONFIG_STATUS_WARNINGS:
+            return "warnings";
+        case CONFIG_STATUS_ERRORS:
+            return "errors";
+        case CONFIG_STATUS_INVALID:
+            return "invalid";
+        case CONFIG_STATUS_MISSING:
+            return "missing";
+    }
+    return "?";
+}
+
+static void addDiagnostic(ConfigDiagnostics &diagnostics, ConfigStatus status, const char *fmt,
+                          va_list args) {
+    char message[256];
+    vsnprintf(message, sizeof(message), fmt, args);
+
+    if (status == CONFIG_STATUS_WARNINGS) {
+        LOGD("%s", message);
+        diagnostics.messages.push_back(std::string("W ") + message);
+    } else {
+        LOGE("%s", message);
+        diagnostics.messages.push_back(std::string("E ") + message);
+    }
+
+    if (status > diagnostics.status) diagnostics.status = status;
+}
+
+void ConfigDiagnostics::warning(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    addDiagnostic(*this, CONFIG_STATUS_WARNINGS, fmt, args);
+    va_end(args);
+}
+
+void ConfigDiagnostics::error(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    addDiagnostic(*this, CONFIG_STATUS_ERRORS, fmt, args);
+    va_end(args);
+}
+
+void ConfigDiagnostics::fail(ConfigStatus failure, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    addDiagnostic(*this, failure, fmt, args);
+    va_end(args);
+}
+
+static bool isDigits(std::string_view str) {
+    for (char c: str) {
+        if (c < '0' || c > '9') return false;
+    }
+    return !str.empty();
+}
+
+// YYYY-MM-DD, like ro.build.version.security_patch
+static bool isPatchDate(std::string_view date) {
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') return false;
+
+    if (!isDigits(date.substr(0, 4)) || !isDigits(date.substr(5, 2)) || !isDigits(date.substr(8, 2)))
+        return false;
+
+    int month = (date[5] - '0') * 10 + date[6] - '0';
+    int day = (date[8] - '0') * 10 + date[9] - '0';
+
+    return month >= 1 && month <= 12 && day >= 1 && day <= 31;
+}
+
+#define SV_ARGS(sv) static_cast<int>((sv).size()), (sv).data()
+
+std::vector<uint8_t> compileConfig(std::span<char> data, ConfigDiagnostics &diagnostics) {
+    if (data.empty()) {
+        diagnostics.fail(CONFIG_STATUS_INVALID, "pif.json is empty!");
+        return {};
+    }
+
+    PifJson json;
+
+    if (!parsePifJson(data, json)) {
+        diagnostics.fail(CONFIG_STATUS_INVALID, "pif.json is not a valid JSON object!");
+        return {};
+    }
+
+    uint32_t flags = CONFIG_SPOOF_PROPS | CONFIG_SPOOF_PROVIDER;
+
+    auto setFlag = [&](const std::optional<bool> &value, uint32_t flag) {
+        if (!value) return;
+        if (*value) flags |= flag;
+        else flags &= ~flag;
+    };
+
+    setFlag(json.spoofProvider, CONFIG_SPOOF_PROVIDER);
+    setFlag(json.spoofProps, CONFIG_SPOOF_PROPS);
+    setFlag(json.spoofSignature, CONFIG_SPOOF_SIGNATURE);
+    setFlag(json.debug, CONFIG_DEBUG);
+
+    std::string_view deviceInitialSdkInt = "21";
+
+    for (size_t i = 0; i < json.mistyped.size(); ++i) {
+        auto [key, type] = json.mistyped[i];
+
+        if (key == "DEVICE_INITIAL_SDK_INT") {
+            diagnostics.error("Couldn't parse DEVICE_INITIAL_SDK_INT value! Found %.*s",
+                              SV_ARGS(type));
+        } else {
+            diagnostics.warning("%.*s has the wrong type (%.*s), it's ignored", SV_ARGS(key),
+                                SV_ARGS(type));
+        }
+    }
+
+    if (json.deviceInitialSdkInt) {
+        // Empty turns the api_level spoofing off
+        if (json.deviceInitialSdkInt->empty() ||
+            (isDigits(*json.deviceInitialSdkInt) && json.deviceInitialSdkInt->size() <= 3)) {
+            deviceInitialSdkInt = *json.deviceInitialSdkInt;
+        } else {
+            diagnostics.error("Couldn't parse DEVICE_INITIAL_SDK_INT value! '%.*s' isn't an SDK level",
+                              SV_ARGS(*json.deviceInitialSdkInt));
+        }
+    }
+
+    for (size_t i = 0; i < json.fields.size(); ++i) {
+        auto [key, value] = json.fields[i];
+
+        if (findBuildField(key) < 0) {
+            diagnostics.warning("%.*s isn't a Build field, it's ignored", SV_ARGS(key));
+        } else if (value.empty()) {
+            diagnostics.warning("%.*s is empty, it's ignored", SV_ARGS(key));
+        }
+    }
+
+    if (auto entry = json.fields.find("SECURITY_PATCH"); entry && !entry->value.empty() &&
+                                                          !isPatchDate(entry->value)) {
+        diagnostics.error("SECURITY_PATCH '%.*s' isn't a YYYY-MM-DD date, it's left out",
+                          SV_ARGS(entry->value));
+        entry->value = {};
+    }
+
+    if (auto entry = json.fields.find("FINGERPRINT"); entry && !entry->value.empty()) {
+        FingerprintParts parts;
+
+        if (auto result = splitFingerprint(entry->value, parts)) {
+            for (uint8_t i = 0; i < FINGERPRINT_PART_COUNT; ++i) {
+                const char *name = fingerprintPartName(static_cast<FingerprintPart>(i));
+
+                // The fingerprint wins, like it always has, but not without saying so
+                auto given = json.fields.find(name);
+                if (given && !given->value.empty() && given->value != parts[i]) {
+                    diagnostics.warning("%s '%.*s' doesn't match FINGERPRINT, it's ignored", name,
+                                        SV_ARGS(given->value));
+                }
+
+                json.fields.add({name, parts[i]});
+            }
+        } else {
+            diagnostics.error("Error parsing fingerprint values! %s is %s, FINGERPRINT is left out",
+                              fingerprintPartName(result.part), fingerprintErrorName(result.error));
+            entry->value = {};
+        }
+    } else {
+        diagnostics.warning("FINGERPRINT is missing, only the fields given are spoofed");
+    }
+
+    std::string_view securityPatch, buildId;
+
+    if (auto entry = json.fields.find("SECURITY_PATCH")) securityPatch = entry->value;
+    if (auto entry = json.fields.find("ID")) buildId = entry->value;
+
+    std::vector<PropRuleSource> rules(std::begin(PROP_FIXED_RULES), std::end(PROP_FIXED_RULES));
+
+    if (!deviceInitialSdkInt.empty()) rules.push_back({PROP_SDK_PATTERN, deviceInitialSdkInt});
+    if (!securityPatch.empty()) rules.push_back({PROP_SECURITY_PATCH_PATTERN, securityPatch});
+    if (!buildId.empty()) rules.push_back({PROP_BUILD_ID_PATTERN, buildId});
+
+    size_t defaultRules = rules.size();
+
+    for (size_t i = 0; i < json.propsMistyped.size(); ++i) {
+        auto [pattern, type] = json.propsMistyped[i];
+        diagnostics.warning("PROPS %.*s has the wrong type (%.*s), it's ignored", SV_ARGS(pattern),
+                            SV_ARGS(type));
+    }
+
+    for (size_t i = 0; i < json.props.size(); ++i) {
+        auto [pattern, value] = json.props[i];
+        PropRuleKind kind;
+
+        if (!classifyPropPattern(pattern, kind)) {
+            diagnostics.error("PROPS '%.*s' isn't a property name pattern, it's left out",
+                              SV_ARGS(pattern));
+            continue;
+        }
+
+        if (value.size() >= PROP_OVERRIDE_MAX) {
+            diagnostics.error("PROPS %.*s value is longer than %d chars, it's left out",
+                              SV_ARGS(pattern), PROP_OVERRIDE_MAX - 1);
+            continue;
+        }
+
+        if (kind == PROP_RULE_GLOB && pattern.front() == '*' && pattern.back() == '*') {
+            diagnostics.warning("PROPS %.*s has no fixed start or end, it's tried on every property",
+                                SV_ARGS(pattern));
+        }
+
+        rules.push_back({pattern, value});
+    }
+
+    auto props = buildPropMatcher(rules);
+
+    if (props.empty()) {
+        diagnostics.error("PROPS has too many rules, only the default ones are used");
+        props = buildPropMatcher(std::span(rules).first(defaultRules));
+    }
+
+    StringPool pool;
+    pool.data.reserve(4096);
+
+    uint32_t strings[CONFIG_STRING_COUNT];
+
+    // Only valid Build fields make it into the config, so the module never looks up a field
+    // through JNI that doesn't exist
+    auto isValidField = [&](size_t i) {
+        return findBuildField(json.fields[i].key) >= 0 && !json.fields[i].value.empty();
+    };
+
+    std::vector<uint8_t> fields;
+
+    for (size_t i = 0; i < json.fields.size(); ++i) {
+        if (!isValidField(i)) continue;
+
+        size_t offset = fields.size();
+        fields.resize(offset + CONFIG_FIELD_SIZE);
+        writeLE<uint32_t>(fields.data() + offset, pool.add(json.fields[i].value));
+        fields[offset + 4] = findBuildField(json.fields[i].key);
+    }
+
+    // EntryPoint gets the same fields, as JSON written straight into the pool. Every other key
+    // has had a warning above, EntryPoint never did anything with them anyway
+    strings[0] = pool.data.size();
+    pool.data.push_back('{');
+
+    for (size_t i = 0; i < json.fields.size(); ++i) {
+        if (!isValidField(i)) continue;
+
+        if (pool.data.back() != '{') pool.data.push_back(',');
+        appendJsonString(pool.data, json.fields[i].key);
+        pool.data.push_back(':');
+        appendJsonString(pool.data, json.fields[i].value);
+    }
+
+    pool.data.push_back('}');
+    pool.data.push_back(0);
+
+    size_t fieldCount = fields.size() / CONFIG_FIELD_SIZE;
+    size_t propsSize = props.size();
+    props.resize((propsSize + 3) & ~size_t(3));
+    size_t size = CONFIG_HEADER_SIZE + sizeof(strings) + fields.size() + props.size() +
+                  pool.data.size();
+
+    if (fieldCount > UINT16_MAX || size > PROTOCOL_MAX_PAYLOAD) {
+        diagnostics.fail(CONFIG_STATUS_INVALID, "pif.json is too big!");
+        return {};
+    }
+
+    std::vector<uint8_t> out(CONFIG_HEADER_SIZE + sizeof(strings));
+    out.reserve(size);
+
+    writeLE<uint32_t>(out.data(), CONFIG_MAGIC);
+    writeLE<uint16_t>(out.data() + 4, CONFIG_VERSION);
+    writeLE<uint16_t>(out.data() + 6, fieldCount);
+    writeLE<uint32_t>(out.data() + 8, flags);
+    writeLE<uint32_t>(out.data() + 12, pool.data.size());
+    writeLE<uint32_t>(out.data() + 16, diagnostics.status);
+    writeLE<uint32_t>(out.data() + 20, propsSize);
+
+    for (int i = 0; i < CONFIG_STRING_COUNT; ++i) {
+        writeLE<uint32_t>(out.data() + CONFIG_HEADER_SIZE + i * 4, strings[i]);
+    }
+
+    out.insert(out.end(), fields.begin(), fields.end());
+    out.insert(out.end(), props.begin(), props.end());
+    out.insert(out.end(), pool.data.begin(), pool.data.end());
+
+    return out;
+}
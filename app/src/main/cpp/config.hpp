@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "buildfields.hpp"
+#include "protocol.hpp"
+
+// Precompiled config record, built once per pif.json change by the companion and also stored
+// as pif.bin next to the pif.json it came from:
+//   header: magic u32, version u16, Build field count u16, flags u32, string pool size u32,
+//           ConfigStatus u32, property matcher size u32
+//   strings: pool offset u32 of the JSON handed to EntryPoint
+//   fields: per Build field, pool offset u32 of the value, u8 index into BUILD_FIELDS, 3 padding
+//   props: the property matcher described in props.hpp, padded to 4
+//   pool: NUL-terminated strings, each distinct string stored once
+// Integers are little-endian and sections are 4-byte aligned. The pool ends with a NUL, so any
+// offset inside it is a valid C string and the record is used in place, without copies.
+#define CONFIG_MAGIC 0x42464950 // PIFB
+#define CONFIG_VERSION 4
+#define CONFIG_HEADER_SIZE 24
+#define CONFIG_STRING_COUNT 1
+#define CONFIG_FIELD_SIZE 8
+
+enum ConfigFlag : uint32_t {
+    CONFIG_SPOOF_PROPS = 1 << 0,
+    CONFIG_SPOOF_PROVIDER = 1 << 1,
+    CONFIG_SPOOF_SIGNATURE = 1 << 2,
+    CONFIG_DEBUG = 1 << 3,
+};
+
+enum ConfigStatus : uint8_t {
+    CONFIG_STATUS_OK,
+    // Something was ignored, such as a key that isn't a Build field
+    CONFIG_STATUS_WARNINGS,
+    // Invalid values were left out of the config
+    CONFIG_STATUS_ERRORS,
+    // Nothing usable, there's no config
+    CONFIG_STATUS_INVALID,
+    CONFIG_STATUS_MISSING,
+};
+
+const char *configStatusName(ConfigStatus status);
+
+// What compiling a pif.json found wrong, the worst problem decides the status
+struct ConfigDiagnostics {
+    ConfigStatus status = CONFIG_STATUS_OK;
+    // Prefixed with W or E
+    std::vector<std::string> messages;
+
+    void warning(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    void error(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    void fail(ConfigStatus status, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+};
+
+struct ConfigView {
+    uint32_t flags = 0;
+    ConfigStatus status = CONFIG_STATUS_OK;
+    const char *javaJson = nullptr;
+    // Checked with parsePropMatcher()
+    std::span<const uint8_t> props;
+    uint16_t fieldCount = 0;
+    const uint8_t *fields = nullptr;
+    const char *pool = nullptr;
+};
+
+bool parseConfig(std::span<const uint8_t> data, ConfigView &config);
+
+// Only valid on a config that went through parseConfig()
+template<typename F>
+void forEachConfigField(const ConfigView &config, F &&onField) {
+    for (uint16_t i = 0; i < config.fieldCount; ++i) {
+        const uint8_t *field = config.fields + i * CONFIG_FIELD_SIZE;
+        onField(BUILD_FIELDS[field[4]], config.pool + readLE<uint32_t>(field));
+    }
+}
+
+// Validates pif.json and compiles what's valid into a config record, empty if nothing is.
+// data is used as scratch space for decoding string escapes.
+std::vector<uint8_t> compileConfig(std::span<char> data, ConfigDiagnostics &diagnostics);
@@ -0,0 +1,61 @@
+#include "fingerprint.hpp"
+
+static constexpr char SEPARATORS[FINGERPRINT_PART_COUNT] = {'/', '/', ':', '/', '/', ':', '/', 0};
+
+static constexpr const char *PART_NAMES[FINGERPRINT_PART_COUNT] = {
+        "BRAND", "PRODUCT", "DEVICE", "RELEASE", "ID", "INCREMENTAL", "TYPE", "TAGS",
+};
+
+FingerprintResult splitFingerprint(std::string_view fingerprint, FingerprintParts &parts) {
+    const char *ptr = fingerprint.data();
+    const char *end = ptr + fingerprint.size();
+
+    for (uint8_t i = 0; i < FINGERPRINT_PART_COUNT; ++i) {
+        auto part = static_cast<FingerprintPart>(i);
+        const char *start = ptr;
+
+        while (ptr < end && *ptr != '/' && *ptr != ':') {
+            // Printable ASCII without spaces, like ro.build.fingerprint
+            if (*ptr <= ' ' || *ptr > '~') return {FINGERPRINT_BAD_CHARACTER, part};
+            ++ptr;
+        }
+
+        if (ptr == start) return {FINGERPRINT_EMPTY_PART, part};
+
+        parts[i] = {start, static_cast<size_t>(ptr - start)};
+
+        if (part == FINGERPRINT_TAGS) {
+            if (ptr != end) return {FINGERPRINT_TRAILING_DATA, part};
+            break;
+        }
+
+        if (ptr == end) return {FINGERPRINT_MISSING_PART, static_cast<FingerprintPart>(i + 1)};
+        if (*ptr != SEPARATORS[i]) return {FINGERPRINT_WRONG_SEPARATOR, part};
+
+        ++ptr;
+    }
+
+    return {};
+}
+
+const char *fingerprintPartName(FingerprintPart part) {
+    return part < FINGERPRINT_PART_COUNT ? PART_NAMES[part] : "?";
+}
+
+const char *fingerprintErrorName(FingerprintError error) {
+    switch (error) {
+        case FINGERPRINT_OK:
+            return "ok";
+        case FINGERPRINT_EMPTY_PART:
+            return "empty";
+        case FINGERPRINT_BAD_CHARACTER:
+            return "using an invalid character";
+        case FINGERPRINT_WRONG_SEPARATOR:
+            return "followed by the wrong separator";
+        case FINGERPRINT_MISSING_PART:
+            return "missing";
+        case FINGERPRINT_TRAILING_DATA:
+            return "followed by trailing data";
+    }
+    return "?";
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// brand/product/device:release/id/incremental:type/tags
+enum FingerprintPart : uint8_t {
+    FINGERPRINT_BRAND,
+    FINGERPRINT_PRODUCT,
+    FINGERPRINT_DEVICE,
+    FINGERPRINT_RELEASE,
+    FINGERPRINT_ID,
+    FINGERPRINT_INCREMENTAL,
+    FINGERPRINT_TYPE,
+    FINGERPRINT_TAGS,
+    FINGERPRINT_PART_COUNT,
+};
+
+enum FingerprintError : uint8_t {
+    FINGERPRINT_OK,
+    FINGERPRINT_EMPTY_PART,
+    FINGERPRINT_BAD_CHARACTER,
+    FINGERPRINT_WRONG_SEPARATOR,
+    FINGERPRINT_MISSING_PART,
+    FINGERPRINT_TRAILING_DATA,
+};
+
+struct FingerprintResult {
+    FingerprintError error = FINGERPRINT_OK;
+    // The part the error was found in
+    FingerprintPart part = FINGERPRINT_BRAND;
+
+    explicit operator bool() const { return error == FINGERPRINT_OK; }
+};
+
+using FingerprintParts = std::array<std::string_view, FINGERPRINT_PART_COUNT>;
+
+// Splits and validates a fingerprint in one pass, parts point into fingerprint
+FingerprintResult splitFingerprint(std::string_view fingerprint, FingerprintParts &parts);
+
+// Build field names, as in BRAND
+const char *fingerprintPartName(FingerprintPart part);
+
+const char *fingerprintErrorName(FingerprintError error);
@@ -0,0 +1,416 @@
+#include "flatjson.hpp"
+
+void FlatJsonEntries::add(FlatJsonEntry entry) {
+    // Later duplicates win, like in any other JSON parser
+    for (size_t i = 0; i < count; ++i) {
+        if (at(i).key == entry.key) {
+            at(i).value = entry.value;
+            return;
+        }
+    }
+
+    if (count < inlineEntries.size()) {
+        inlineEntries[count] = entry;
+    } else {
+        moreEntries.push_back(entry);
+    }
+
+    ++count;
+}
+
+const FlatJsonEntry *FlatJsonEntries::find(std::string_view key) const {
+    for (size_t i = 0; i < count; ++i) {
+        if ((*this)[i].key == key) return &(*this)[i];
+    }
+    return nullptr;
+}
+
+enum ValueKind {
+    VALUE_STRING,
+    VALUE_INTEGER,
+    VALUE_NUMBER,
+    VALUE_TRUE,
+    VALUE_FALSE,
+    VALUE_NULL,
+    VALUE_NESTED,
+};
+
+#define MAX_NESTING 64
+
+struct Parser {
+    char *ptr;
+    char *end;
+
+    bool skipWhitespace() {
+        while (ptr < end) {
+            char c = *ptr;
+
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                ++ptr;
+            } else if (c == '/' && end - ptr >= 2 && ptr[1] == '/') {
+                while (ptr < end && *ptr != '\n') ++ptr;
+            } else if (c == '/' && end - ptr >= 2 && ptr[1] == '*') {
+                ptr += 2;
+                while (end - ptr >= 2 && !(ptr[0] == '*' && ptr[1] == '/')) ++ptr;
+                if (end - ptr < 2) return false;
+                ptr += 2;
+            } else {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool consume(char c) {
+        if (!skipWhitespace() || ptr >= end || *ptr != c) return false;
+        ++ptr;
+        return true;
+    }
+
+    bool parseHex4(uint32_t &value) {
+        if (end - ptr < 4) return false;
+
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *ptr++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    // Decodes the string in place, the decoded form is never longer than the escaped one
+    bool parseString(std::string_view &out) {
+        if (ptr >= end || *ptr != '"') return false;
+        ++ptr;
+
+        char *start = ptr;
+        char *dst = ptr;
+
+        while (true) {
+            if (ptr >= end) return false;
+
+            char c = *ptr++;
+
+            if (c == '"') break;
+
+            if (static_cast<unsigned char>(c) < 0x20) return false;
+
+            if (c != '\\') {
+                *dst++ = c;
+                continue;
+            }
+
+            if (ptr >= end) return false;
+
+            switch (*ptr++) {
+                case '"':
+                    *dst++ = '"';
+                    break;
+                case '\\':
+                    *dst++ = '\\';
+                    break;
+                case '/':
+                    *dst++ = '/';
+                    break;
+                case 'b':
+                    *dst++ = '\b';
+                    break;
+                case 'f':
+                    *dst++ = '\f';
+                    break;
+                case 'n':
+                    *dst++ = '\n';
+                    break;
+                case 'r':
+                    *dst++ = '\r';
+                    break;
+                case 't':
+                    *dst++ = '\t';
+                    break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!parseHex4(cp)) return false;
+
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        uint32_t low;
+                        if (end - ptr < 2 || ptr[0] != '\\' || ptr[1] != 'u') return false;
+                        ptr += 2;
+                        if (!parseHex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else if ((cp >= 0xDC00 && cp <= 0xDFFF) || cp == 0) {
+                        // A NUL would cut the value short once it's used as a C string
+                        return false;
+                    }
+
+                    if (cp < 0x80) {
+                        *dst++ = static_cast<char>(cp);
+                    } else if (cp < 0x800) {
+                        *dst++ = static_cast<char>(0xC0 | (cp >> 6));
+                        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+                    } else if (cp < 0x10000) {
+                        *dst++ = static_cast<char>(0xE0 | (cp >> 12));
+                        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+                    } else {
+                        *dst++ = static_cast<char>(0xF0 | (cp >> 18));
+                        *dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                        *dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                        *dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        out = {start, static_cast<size_t>(dst - start)};
+        return true;
+    }
+
+    bool parseKeyword(std::string_view keyword) {
+        if (static_cast<size_t>(end - ptr) < keyword.size() ||
+            std::string_view(ptr, keyword.size()) != keyword)
+            return false;
+        ptr += keyword.size();
+        return true;
+    }
+
+    bool parseNumber(std::string_view &out, ValueKind &kind) {
+        char *start = ptr;
+
+        if (ptr < end && *ptr == '-') ++ptr;
+
+        auto digits = [&] {
+            char *from = ptr;
+            while (ptr < end && *ptr >= '0' && *ptr <= '9') ++ptr;
+            return ptr > from;
+        };
+
+        if (!digits()) return false;
+
+        kind = VALUE_INTEGER;
+
+        if (ptr < end && *ptr == '.') {
+            ++ptr;
+            if (!digits()) return false;
+            kind = VALUE_NUMBER;
+        }
+
+        if (ptr < end && (*ptr == 'e' || *ptr == 'E')) {
+            ++ptr;
+            if (ptr < end && (*ptr == '+' || *ptr == '-')) ++ptr;
+            if (!digits()) return false;
+            kind = VALUE_NUMBER;
+        }
+
+        out = {start, static_cast<size_t>(ptr - start)};
+        return true;
+    }
+
+    bool parseValue(std::string_view &out, ValueKind &kind, int depth) {
+        if (!skipWhitespace() || ptr >= end) return false;
+
+        switch (*ptr) {
+            case '"':
+                kind = VALUE_STRING;
+                return parseString(out);
+            case 't':
+                kind = VALUE_TRUE;
+                return parseKeyword("true");
+            case 'f':
+                kind = VALUE_FALSE;
+                return parseKeyword("false");
+            case 'n':
+                kind = VALUE_NULL;
+                return parseKeyword("null");
+            case '{':
+            case '[':
+                kind = VALUE_NESTED;
+                return skipNested(depth + 1);
+            default:
+                return parseNumber(out, kind);
+        }
+    }
+
+    bool skipNested(int depth) {
+        if (depth > MAX_NESTING) return false;
+
+        char close = *ptr++ == '{' ? '}' : ']';
+        bool object = close == '}';
+
+        if (!skipWhitespace()) return false;
+        if (ptr < end && *ptr == close) {
+            ++ptr;
+            return true;
+        }
+
+        while (true) {
+            std::string_view value;
+            ValueKind kind;
+
+            if (object) {
+                if (!skipWhitespace() || !parseString(value) || !consume(':')) return false;
+            }
+
+            if (!parseValue(value, kind, depth)) return false;
+
+            if (!skipWhitespace() || ptr >= end) return false;
+            if (*ptr == ',') {
+                ++ptr;
+                continue;
+            }
+            if (*ptr == close) {
+                ++ptr;
+                return true;
+            }
+            return false;
+        }
+    }
+};
+
+static const char *kindName(ValueKind kind) {
+    switch (kind) {
+        case VALUE_STRING:
+            return "string";
+        case VALUE_INTEGER:
+        case VALUE_NUMBER:
+            return "number";
+        case VALUE_TRUE:
+        case VALUE_FALSE:
+            return "boolean";
+        case VALUE_NULL:
+            return "null";
+        case VALUE_NESTED:
+            return "object or array";
+    }
+    return "?";
+}
+
+static void setBoolean(PifJson &json, std::optional<bool> &target, std::string_view key,
+                       ValueKind kind) {
+    if (kind == VALUE_TRUE) target = true;
+    else if (kind == VALUE_FALSE) target = false;
+    else json.mistyped.add({key, kindName(kind)});
+}
+
+// PROPS is the one nested object, a flat object of strings itself
+static bool parseProps(Parser &parser, PifJson &json) {
+    ++parser.ptr;
+
+    if (!parser.skipWhitespace()) return false;
+
+    if (parser.ptr < parser.end && *parser.ptr == '}') {
+        ++parser.ptr;
+        return true;
+    }
+
+    while (true) {
+        std::string_view pattern, value;
+        ValueKind kind;
+
+        if (!parser.skipWhitespace() || !parser.parseString(pattern) || !parser.consume(':') ||
+            !parser.parseValue(value, kind, 1))
+            return false;
+
+        if (kind == VALUE_STRING) {
+            json.props.add({pattern, value});
+        } else {
+            json.propsMistyped.add({pattern, kindName(kind)});
+        }
+
+        if (!parser.skipWhitespace() || parser.ptr >= parser.end) return false;
+
+        char c = *parser.ptr++;
+        if (c == '}') return true;
+        if (c != ',') return false;
+    }
+}
+
+bool parsePifJson(std::span<char> data, PifJson &json) {
+    Parser parser{data.data(), data.data() + data.size()};
+
+    // Editors on Windows like to start files with a UTF-8 byte order mark
+    if (std::string_view(data.data(), data.size()).starts_with("\xEF\xBB\xBF")) parser.ptr += 3;
+
+    if (!parser.consume('{')) return false;
+
+    if (!parser.skipWhitespace()) return false;
+
+    bool empty = parser.ptr < parser.end && *parser.ptr == '}';
+
+    if (empty) {
+        ++parser.ptr;
+    }
+
+    while (!empty) {
+        std::string_view key, value;
+        ValueKind kind;
+
+        if (!parser.skipWhitespace() || !parser.parseString(key) || !parser.consume(':') ||
+            !parser.skipWhitespace())
+            return false;
+
+        if (key == "PROPS" && parser.ptr < parser.end && *parser.ptr == '{') {
+            if (!parseProps(parser, json)) return false;
+        } else if (!parser.parseValue(value, kind, 0)) {
+            return false;
+        } else if (key == "spoofProvider") {
+            setBoolean(json, json.spoofProvider, key, kind);
+        } else if (key == "spoofProps") {
+            setBoolean(json, json.spoofProps, key, kind);
+        } else if (key == "spoofSignature") {
+            setBoolean(json, json.spoofSignature, key, kind);
+        } else if (key == "DEBUG") {
+            setBoolean(json, json.debug, key, kind);
+        } else if (key == "DEVICE_INITIAL_SDK_INT") {
+            if (kind == VALUE_STRING || kind == VALUE_INTEGER) {
+                json.deviceInitialSdkInt = value;
+            } else {
+                json.deviceInitialSdkInt.reset();
+                json.mistyped.add({key, kindName(kind)});
+            }
+        } else if (key == "PROPS") {
+            json.mistyped.add({key, kindName(kind)});
+        } else if (kind == VALUE_STRING) {
+            json.fields.add({key, value});
+        } else {
+            json.mistyped.add({key, kindName(kind)});
+        }
+
+        if (!parser.skipWhitespace() || parser.ptr >= parser.end) return false;
+
+        char c = *parser.ptr++;
+        if (c == '}') break;
+        if (c != ',') return false;
+    }
+
+    return parser.skipWhitespace() && parser.ptr == parser.end;
+}
+
+void appendJsonString(std::vector<uint8_t> &out, std::string_view str) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    out.push_back('"');
+
+    for (char c: str) {
+        auto u = static_cast<unsigned char>(c);
+
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(u);
+        } else if (u < 0x20) {
+            const uint8_t escaped[] = {'\\', 'u', '0', '0', static_cast<uint8_t>(HEX[u >> 4]),
+                                       static_cast<uint8_t>(HEX[u & 0xF])};
+            out.insert(out.end(), std::begin(escaped), std::end(escaped));
+        } else {
+            out.push_back(u);
+        }
+    }
+
+    out.push_back('"');
+}
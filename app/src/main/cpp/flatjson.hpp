@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+struct FlatJsonEntry {
+    std::string_view key;
+    std::string_view value;
+};
+
+// Entries live inline until there are more than a typical pif.json has
+class FlatJsonEntries {
+public:
+    void add(FlatJsonEntry entry);
+
+    // Linear, pif.json has a few dozen keys at most
+    const FlatJsonEntry *find(std::string_view key) const;
+
+    FlatJsonEntry *find(std::string_view key) {
+        return const_cast<FlatJsonEntry *>(static_cast<const FlatJsonEntries *>(this)->find(key));
+    }
+
+    size_t size() const { return count; }
+
+    const FlatJsonEntry &operator[](size_t i) const {
+        return i < inlineEntries.size() ? inlineEntries[i] : moreEntries[i - inlineEntries.size()];
+    }
+
+private:
+    FlatJsonEntry &at(size_t i) {
+        return i < inlineEntries.size() ? inlineEntries[i] : moreEntries[i - inlineEntries.size()];
+    }
+
+    std::array<FlatJsonEntry, 32> inlineEntries{};
+    std::vector<FlatJsonEntry> moreEntries;
+    size_t count = 0;
+};
+
+// pif.json is a flat object of strings, integers and booleans, plus the PROPS object
+struct PifJson {
+    std::optional<bool> spoofProvider;
+    std::optional<bool> spoofProps;
+    std::optional<bool> spoofSignature;
+    std::optional<bool> debug;
+
+    // Either a JSON string or the literal of a JSON integer
+    std::optional<std::string_view> deviceInitialSdkInt;
+
+    // Every other key with a string value in file order, FINGERPRINT and SECURITY_PATCH included
+    FlatJsonEntries fields;
+
+    // Keys skipped for having a value of the wrong type, with the JSON type they had
+    FlatJsonEntries mistyped;
+
+    // The PROPS object, property name patterns and the values reported for them, in file order
+    FlatJsonEntries props;
+
+    // PROPS entries that aren't strings, with the JSON type they had
+    FlatJsonEntries propsMistyped;
+};
+
+// Parses pif.json, string escapes are decoded in place so every view points into data.
+// Comments and a leading byte order mark are allowed, \u0000 isn't. Keys with values of the
+// wrong type end up in mistyped.
+bool parsePifJson(std::span<char> data, PifJson &json);
+
+// Appends str as a quoted, escaped JSON string
+void appendJsonString(std::vector<uint8_t> &out, std::string_view str);
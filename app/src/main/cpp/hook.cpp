@@ -0,0 +1,75 @@
+#include <cstring>
+#include <ctime>
+#include "hook.hpp"
+#include "logonce.hpp"
+
+static HookState state;
+
+// Hot apps read the same properties over and over, each change is only logged once
+static LogOnce hookLog;
+
+// Stands in for the caller's cookie for the length of one read, so reads on other threads with
+// other callbacks can't end up calling this one's
+struct ReadTrampoline {
+    T_Callback callback;
+    void *cookie;
+    // Filled in by modify_callback for the stats
+    const char *name = nullptr;
+    bool overridden = false;
+};
+
+static uint64_t monotonicNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static void modify_callback(void *cookie, const char *name, const char *value, uint32_t serial) {
+    auto *trampoline = static_cast<ReadTrampoline *>(cookie);
+
+    if (!name || !value) return trampoline->callback(trampoline->cookie, name, value, serial);
+
+    std::span<const uint8_t> props(state.props, state.propsSize);
+
+    int32_t offset = props.empty() ? -1 : findPropValue(props, name);
+
+    // An empty value turns a rule off, and values are only compared for spoofed properties
+    if (offset >= 0 &&
+        (*propValue(props, offset) == 0 || strcmp(value, propValue(props, offset)) == 0)) {
+        offset = -1;
+    }
+
+    trampoline->name = name;
+    trampoline->overridden = offset >= 0;
+
+    if (offset >= 0) {
+        hookLog.log("[%s]: %s -> %s", name, value, propValue(props, offset));
+        value = propValue(props, offset);
+    } else if (state.debug) {
+        hookLog.log("[%s]: %s (unchanged)", name, value);
+    }
+
+    return trampoline->callback(trampoline->cookie, name, value, serial);
+}
+
+static void my_system_property_read_callback(const prop_info *pi, T_Callback callback,
+                                             void *cookie) {
+    if (!pi || !callback) return state.original(pi, callback, cookie);
+
+    // The callback runs before the read returns, so the trampoline can live on the stack
+    ReadTrampoline trampoline{callback, cookie};
+
+    if (!state.stats) return state.original(pi, modify_callback, &trampoline);
+
+    uint64_t start = monotonicNs();
+    state.original(pi, modify_callback, &trampoline);
+    uint64_t ns = monotonicNs() - start;
+
+    if (trampoline.name) recordPropRead(*state.stats, trampoline.name, trampoline.overridden, ns);
+}
+
+extern "C" [[gnu::visibility("default")]] HookState *pifHookState() {
+    state.replacement = my_system_property_read_callback;
+    state.flushLog = [] { hookLog.flush(); };
+    return &state;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#else
+// Host tests drive the hook with their own property reads, they only need the type
+struct prop_info;
+#endif
+
+#include "props.hpp"
+#include "propstats.hpp"
+
+typedef void (*T_Callback)(void *, const char *, const char *, uint32_t);
+
+typedef void (*T_ReadCallback)(const prop_info *, T_Callback, void *);
+
+// Everything the property hook needs after the main library unloaded itself. It lives in the
+// hook stub library, or in the main library when the stub couldn't be loaded.
+struct HookState {
+    // A read-only copy of the config's matcher, which goes away with the rest of the launch's
+    // arena. Mapped by the module at the matcher's size, so the stub has no buffer of its own.
+    const uint8_t *props = nullptr;
+    uint32_t propsSize = 0;
+    bool debug = false;
+    // Hook for __system_property_read_callback
+    T_ReadCallback replacement = nullptr;
+    // Set by DobbyHook to the trampoline calling the real __system_property_read_callback
+    T_ReadCallback original = nullptr;
+    // Logs how often each property change was logged again since the last call
+    void (*flushLog)() = nullptr;
+    // Shared with the companion, nullptr when it sent none
+    PropStats *stats = nullptr;
+};
+
+#define HOOK_STUB_NAME "libpifhook.so"
+#define HOOK_TARGET "__system_property_read_callback"
+#define HOOK_STATE_SYMBOL "pifHookState"
+
+extern "C" HookState *pifHookState();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+// Java string checks for preAppSpecialize, which runs for every app zygote forks. Env and String
+// are JNIEnv and jstring in the module, the host tests use a fake of both.
+
+// Compares the tail of a Java string with an ASCII suffix, copying only that tail to the stack
+template<typename Env, typename String>
+inline bool jstringEndsWith(Env *env, String str, std::string_view suffix) {
+    constexpr size_t MAX_SUFFIX = 64;
+
+    if (!str || suffix.size() > MAX_SUFFIX) return false;
+
+    auto len = env->GetStringLength(str);
+    auto suffixLen = static_cast<decltype(len)>(suffix.size());
+
+    if (len < suffixLen) return false;
+
+    // Non-ASCII chars take up to 3 bytes in modified UTF-8 and then can't match anyway
+    char buffer[MAX_SUFFIX * 3 + 1]{};
+    env->GetStringUTFRegion(str, len - suffixLen, suffixLen, buffer);
+
+    return strncmp(buffer, suffix.data(), suffix.size()) == 0 && buffer[suffix.size()] == 0;
+}
+
+template<typename Env, typename String>
+inline bool jstringEquals(Env *env, String str, std::string_view value) {
+    if (!str) return false;
+
+    auto len = env->GetStringLength(str);
+    return len == static_cast<decltype(len)>(value.size()) && jstringEndsWith(env, str, value);
+}
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include "launchreports.hpp"
+
+bool isLaunchReports(const void *region, size_t size) {
+    if (size != sizeof(LaunchReports)) return false;
+
+    auto *reports = static_cast<const LaunchReports *>(region);
+    return reports->magic == LAUNCH_REPORTS_MAGIC && reports->version == LAUNCH_REPORTS_VERSION;
+}
+
+bool postLaunchReport(LaunchReports &reports, const LaunchReport &report) {
+    for (auto &slot: reports.slots) {
+        uint32_t expected = LAUNCH_REPORT_FREE;
+
+        if (!slot.state.compare_exchange_strong(expected, LAUNCH_REPORT_WRITING,
+                                                std::memory_order_acquire))
+            continue;
+
+        slot.report = report;
+        slot.report.sequence = reports.nextSequence.fetch_add(1, std::memory_order_relaxed);
+        slot.state.store(LAUNCH_REPORT_READY, std::memory_order_release);
+        return true;
+    }
+
+    reports.dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+size_t takeLaunchReports(LaunchReports &reports, LaunchReport (&out)[LAUNCH_REPORT_SLOTS]) {
+    size_t count = 0;
+
+    for (auto &slot: reports.slots) {
+        uint32_t expected = LAUNCH_REPORT_READY;
+
+        // Companion threads take reports concurrently, each one goes to a single taker
+        if (!slot.state.compare_exchange_strong(expected, LAUNCH_REPORT_WRITING,
+                                                std::memory_order_acquire))
+            continue;
+
+        out[count] = slot.report;
+        out[count].phaseCount = std::min<uint32_t>(out[count].phaseCount, LAUNCH_REPORT_PHASES);
+        ++count;
+
+        slot.state.store(LAUNCH_REPORT_FREE, std::memory_order_release);
+    }
+
+    std::sort(out, out + count, [](auto &a, auto &b) { return a.sequence < b.sequence; });
+
+    return count;
+}
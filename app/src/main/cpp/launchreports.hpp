@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Launch reports, a region the companion shares with every module it sends a config to.
+// connectCompanion() only works before specialization, so the module can't send what it
+// measured afterwards. It leaves a report here instead, and the companion picks reports up
+// when the next module asks for its config. Everything is 32-bit so 32 and 64-bit processes
+// agree on the layout.
+#define LAUNCH_REPORTS_MAGIC 0x524c4950 // PILR
+#define LAUNCH_REPORTS_VERSION 1
+// Reports waiting for the companion, more launches than this in a row are dropped
+#define LAUNCH_REPORT_SLOTS 8
+// Room for phases added later, a report says how many it has
+#define LAUNCH_REPORT_PHASES 16
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Reports are shared by processes");
+
+struct LaunchReport {
+    // Order the reports were posted in
+    uint32_t sequence = 0;
+    uint32_t roundTripUs = 0;
+    // Most bytes the module's arena held between the specialization hooks
+    uint32_t arenaPeak = 0;
+    uint32_t phaseCount = 0;
+    uint32_t phaseUs[LAUNCH_REPORT_PHASES]{};
+};
+
+enum LaunchReportState : uint32_t {
+    LAUNCH_REPORT_FREE,
+    // A module is filling it in, or the companion is taking it
+    LAUNCH_REPORT_WRITING,
+    LAUNCH_REPORT_READY,
+};
+
+struct LaunchReportSlot {
+    std::atomic<uint32_t> state{LAUNCH_REPORT_FREE};
+    // Only touched by whoever moved state away from FREE or READY
+    LaunchReport report;
+};
+
+struct LaunchReports {
+    uint32_t magic = LAUNCH_REPORTS_MAGIC;
+    uint32_t version = LAUNCH_REPORTS_VERSION;
+    std::atomic<uint32_t> nextSequence{0};
+    // Reports that found no free slot
+    std::atomic<uint32_t> dropped{0};
+    LaunchReportSlot slots[LAUNCH_REPORT_SLOTS];
+};
+
+// Checks a region received from the companion before the module writes to it
+bool isLaunchReports(const void *region, size_t size);
+
+// Copies report into a free slot, its sequence is assigned here. False when none is free.
+bool postLaunchReport(LaunchReports &reports, const LaunchReport &report);
+
+// Moves every posted report out, oldest first, and frees their slots. Any process the region
+// went to can write to it, so phaseCount is clamped. Returns how many were taken.
+size_t takeLaunchReports(LaunchReports &reports, LaunchReport (&out)[LAUNCH_REPORT_SLOTS]);
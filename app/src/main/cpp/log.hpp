@@ -0,0 +1,18 @@
+#pragma once
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "PIF", __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "PIF", __VA_ARGS__)
+
+#else
+
+#include <cstdio>
+
+// Host builds of the core library log to stderr
+#define LOGD(fmt, ...) fprintf(stderr, "D PIF: " fmt "\n", ##__VA_ARGS__)
+#define LOGE(fmt, ...) fprintf(stderr, "E PIF: " fmt "\n", ##__VA_ARGS__)
+
+#endif
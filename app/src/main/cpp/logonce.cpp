@@ -0,0 +1,104 @@
+#include <ctime>
+#include "log.hpp"
+#include "logonce.hpp"
+
+static int64_t coarseNowMs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t LogOnce::mix(uint64_t hash, const char *str) {
+    hash ^= 0xFF; // Separates the arguments, "ab" "c" and "a" "bc" differ
+    hash *= 1099511628211ull;
+
+    for (; str && *str; ++str) {
+        hash ^= static_cast<uint8_t>(*str);
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+bool LogOnce::counted(uint64_t hash) {
+    if (hash == 0) hash = 1;
+
+    for (size_t probe = 0; probe < LOG_ONCE_PROBES; ++probe) {
+        Slot &slot = slots[(hash + probe) % LOG_ONCE_SLOTS];
+        uint64_t current = slot.hash.load(std::memory_order_relaxed);
+
+        if (current == 0) break;
+
+        if (current == hash) {
+            slot.repeats.fetch_add(1, std::memory_order_relaxed);
+            maybeFlush();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LogOnce::record(uint64_t hash, const char *message) {
+    if (hash == 0) hash = 1;
+
+    for (size_t probe = 0; probe < LOG_ONCE_PROBES; ++probe) {
+        Slot &slot = slots[(hash + probe) % LOG_ONCE_SLOTS];
+        uint64_t current = 0;
+
+        if (slot.hash.compare_exchange_strong(current, hash, std::memory_order_relaxed)) {
+            snprintf(slot.message, sizeof(slot.message), "%s", message);
+            slot.ready.store(true, std::memory_order_release);
+            LOGD("%s", message);
+            maybeFlush();
+            return;
+        }
+
+        // Another thread got there first with the same message
+        if (current == hash) {
+            slot.repeats.fetch_add(1, std::memory_order_relaxed);
+            maybeFlush();
+            return;
+        }
+    }
+
+    if (burst.fetch_add(1, std::memory_order_relaxed) < LOG_ONCE_BURST) {
+        LOGD("%s", message);
+    } else {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    maybeFlush();
+}
+
+void LogOnce::maybeFlush() {
+    int64_t now = coarseNowMs();
+    int64_t last = lastFlushMs.load(std::memory_order_relaxed);
+
+    if (last == 0) {
+        // The interval starts with the first message
+        lastFlushMs.compare_exchange_strong(last, now, std::memory_order_relaxed);
+        return;
+    }
+
+    // Only the thread that moves lastFlushMs forward flushes
+    if (now - last >= LOG_ONCE_FLUSH_INTERVAL_MS &&
+        lastFlushMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        flush();
+    }
+}
+
+void LogOnce::flush() {
+    for (auto &slot: slots) {
+        if (!slot.ready.load(std::memory_order_acquire)) continue;
+
+        uint32_t repeats = slot.repeats.exchange(0, std::memory_order_relaxed);
+        if (repeats) LOGD("%s (%u more times)", slot.message, repeats);
+    }
+
+    if (uint32_t count = dropped.exchange(0, std::memory_order_relaxed)) {
+        LOGD("%u more messages weren't logged", count);
+    }
+
+    burst.store(0, std::memory_order_relaxed);
+}
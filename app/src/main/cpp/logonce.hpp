@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#define LOG_ONCE_SLOTS 128
+#define LOG_ONCE_MESSAGE_SIZE 192
+// Slots tried before a message counts as not fitting
+#define LOG_ONCE_PROBES 8
+// How often repeats are summarized without being asked to
+#define LOG_ONCE_FLUSH_INTERVAL_MS 10000
+// Messages that didn't fit logged per interval, the rest are only counted
+#define LOG_ONCE_BURST 32
+
+// Logs every distinct message once, repeats are only counted and show up in a summary when
+// flush() is called or every LOG_ONCE_FLUSH_INTERVAL_MS. Messages are told apart by a hash of
+// their format and arguments, so a repeat costs a hash and an atomic add instead of a write to
+// logd. Lock-free, and nothing is allocated after construction.
+class LogOnce {
+public:
+    // fmt must be a literal with only %s conversions, each argument a C string
+    template<typename... Args>
+    void log(const char *fmt, Args... args) {
+        uint64_t hash = reinterpret_cast<uintptr_t>(fmt);
+        ((hash = mix(hash, args)), ...);
+
+        if (counted(hash)) return;
+
+        char message[LOG_ONCE_MESSAGE_SIZE];
+        if constexpr (sizeof...(args) == 0) snprintf(message, sizeof(message), "%s", fmt);
+        else snprintf(message, sizeof(message), fmt, args...);
+        record(hash, message);
+    }
+
+    void flush();
+
+private:
+    struct Slot {
+        // 0 while the slot is free
+        std::atomic<uint64_t> hash{0};
+        std::atomic<uint32_t> repeats{0};
+        // Set once message is written
+        std::atomic<bool> ready{false};
+        char message[LOG_ONCE_MESSAGE_SIZE];
+    };
+
+    static uint64_t mix(uint64_t hash, const char *str);
+
+    // True when hash was logged before, which counts it as a repeat
+    bool counted(uint64_t hash);
+
+    void record(uint64_t hash, const char *message);
+
+    void maybeFlush();
+
+    Slot slots[LOG_ONCE_SLOTS];
+    std::atomic<int64_t> lastFlushMs{0};
+    std::atomic<uint32_t> burst{0};
+    std::atomic<uint32_t> dropped{0};
+};
@@ -1,128 +1,172 @@
-#include <android/log.h>
+#include <android/dlext.h>
+#include <android/trace.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/system_properties.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <thread>
 #include "zygisk.hpp"
 #include "dobby.h"
-#include "json.hpp"
-
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "PIF", __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "PIF", __VA_ARGS__)
-
-#define DEX_PATH "/data/adb/modules/playintegrityfix/classes.dex"
+#include "arena.hpp"
+#include "config.hpp"
+#include "hook.hpp"
+#include "jstrings.hpp"
+#include "launchreports.hpp"
+#include "log.hpp"
+#include "logonce.hpp"
+#include "profiles.hpp"
+#include "props.hpp"
+#include "propstats.hpp"
+#include "protocol.hpp"
+#include "symbols.hpp"
+#include "zip.hpp"
+
+#define MODULE_DIR "/data/adb/modules/playintegrityfix"
+#define DEX_PATH MODULE_DIR "/classes.dex"
+
+#if defined(__aarch64__)
+#define ABI "arm64-v8a"
+#elif defined(__arm__)
+#define ABI "armeabi-v7a"
+#elif defined(__x86_64__)
+#define ABI "x86_64"
+#elif defined(__i386__)
+#define ABI "x86"
+#endif
+
+// The companion runs with the same ABI as the module asking for the stub
+#define HOOK_STUB_PATH MODULE_DIR "/lib/" ABI "/" HOOK_STUB_NAME
 
 #define TS_PATH "/data/adb/modules/tricky_store"
 
-#define DEFAULT_JSON "/data/adb/modules/playintegrityfix/pif.json"
-#define CUSTOM_JSON_FORK "/data/adb/modules/playintegrityfix/custom.pif.json"
-#define CUSTOM_JSON "/data/adb/pif.json"
+#define OTA_CERTS_PATH "/system/etc/security/otacerts.zip"
+
+#define DEFAULT_JSON MODULE_DIR "/pif.json"
+#define CUSTOM_JSON_FORK MODULE_DIR "/custom.pif.json"
+#define CUSTOM_JSON_DIR "/data/adb"
+#define CUSTOM_JSON CUSTOM_JSON_DIR "/pif.json"
+
+// One pif.json per profile, plus a selection file picking one of them
+#define PROFILES_NAME "pif_profiles"
+#define PROFILES_DIR CUSTOM_JSON_DIR "/" PROFILES_NAME
+#define PROFILES_SELECTION PROFILES_DIR "/selection"
+#define PROFILES_STORE PROFILES_DIR ".bin"
+#define PROFILES_STATE PROFILES_DIR ".state"
+#define BOOT_ID_PATH "/proc/sys/kernel/random/boot_id"
+
+#define TRACE_PATH MODULE_DIR "/trace.txt"
+#define DIAGNOSTICS_PATH MODULE_DIR "/diagnostics.txt"
+#define PROP_STATS_PATH MODULE_DIR "/propstats.txt"
+#define TRACE_HISTORY 20
+
+// Upper bound for a whole companion message in either direction
+#ifndef COMPANION_TIMEOUT_MS
+#define COMPANION_TIMEOUT_MS 1000
+#endif
+
+// Address space for the module's transient data, only the pages used cost memory
+#ifndef ARENA_SIZE
+#define ARENA_SIZE (2 << 20)
+#endif
+
+enum TracePhase : uint8_t {
+    PHASE_CONNECT_COMPANION,
+    PHASE_COMPANION_IO,
+    PHASE_PARSE_CONFIG,
+    PHASE_UPDATE_BUILD_FIELDS,
+    PHASE_CREATE_CLASS_LOADER,
+    PHASE_LOAD_CLASS,
+    PHASE_ENTRY_POINT_INIT,
+    PHASE_DO_HOOK,
+    // Appended so older traces still line up, it's timed right before PHASE_DO_HOOK
+    PHASE_RESOLVE_HOOK,
+    PHASE_COUNT,
+};
 
-static ssize_t xread(int fd, void *buffer, size_t count_to_read) {
-    ssize_t total_read = 0;
-    char *current_buf = static_cast<char *>(buffer);
-    size_t remaining_bytes = count_to_read;
+// reportTrace copies every phase into the shared launch report
+static_assert(PHASE_COUNT <= LAUNCH_REPORT_PHASES, "Launch reports can't hold every phase");
+
+static constexpr const char *PHASE_NAMES[PHASE_COUNT] = {
+        "connectCompanion",
+        "companionIO",
+        "parseConfig",
+        "UpdateBuildFields",
+        "createClassLoader",
+        "loadClass",
+        "EntryPoint.init",
+        "doHook",
+        "resolveHook",
+};
 
-    while (remaining_bytes > 0) {
-        ssize_t ret = TEMP_FAILURE_RETRY(read(fd, current_buf, remaining_bytes));
+static int64_t phaseNs[PHASE_COUNT];
+static bool atraceEnabled = false;
 
-        if (ret < 0) {
-            return -1;
-        }
+static LogOnce moduleLog;
 
-        if (ret == 0) {
-            break;
-        }
-
-        current_buf += ret;
-        total_read += ret;
-        remaining_bytes -= ret;
+// Times a module lifecycle phase, shown as an ATrace section when tracing is enabled
+class PhaseTimer {
+public:
+    explicit PhaseTimer(TracePhase phase) : phase(phase), start(nowNs()) {
+        if (atraceEnabled) ATrace_beginSection(PHASE_NAMES[phase]);
     }
 
-    return total_read;
-}
-
-static ssize_t xwrite(int fd, const void *buffer, size_t count_to_write) {
-    ssize_t total_written = 0;
-    const char *current_buf = static_cast<const char *>(buffer);
-    size_t remaining_bytes = count_to_write;
-
-    while (remaining_bytes > 0) {
-        ssize_t ret = TEMP_FAILURE_RETRY(write(fd, current_buf, remaining_bytes));
-
-        if (ret < 0) {
-            return -1;
-        }
-
-        if (ret == 0) {
-            break;
-        }
-
-        current_buf += ret;
-        total_written += ret;
-        remaining_bytes -= ret;
+    ~PhaseTimer() {
+        stop();
     }
 
-    return total_written;
-}
-
-static bool DEBUG = false;
-static std::string DEVICE_INITIAL_SDK_INT = "21", SECURITY_PATCH, BUILD_ID;
+    void stop() {
+        if (stopped) return;
+        stopped = true;
 
-typedef void (*T_Callback)(void *, const char *, const char *, uint32_t);
-
-static T_Callback o_callback = nullptr;
-
-static void modify_callback(void *cookie, const char *name, const char *value, uint32_t serial) {
-
-    if (!cookie || !name || !value || !o_callback) return;
-
-    const char *oldValue = value;
+        if (atraceEnabled) ATrace_endSection();
+        phaseNs[phase] += nowNs() - start;
+    }
 
-    std::string_view prop(name);
+private:
+    TracePhase phase;
+    int64_t start;
+    bool stopped = false;
+};
 
-    if (prop == "init.svc.adbd") {
-        value = "stopped";
-    } else if (prop == "sys.usb.state") {
-        value = "mtp";
-    } else if (prop.ends_with("api_level")) {
-        if (!DEVICE_INITIAL_SDK_INT.empty()) {
-            value = DEVICE_INITIAL_SDK_INT.c_str();
-        }
-    } else if (prop.ends_with(".security_patch")) {
-        if (!SECURITY_PATCH.empty()) {
-            value = SECURITY_PATCH.c_str();
-        }
-    } else if (prop.ends_with(".build.id")) {
-        if (!BUILD_ID.empty()) {
-            value = BUILD_ID.c_str();
-        }
-    }
+// Cheapest first: the offset the companion resolved for this libc, a lookup in libc alone and
+// last Dobby, which goes through the symbol tables of every loaded image
+static void *resolveHookTarget(const LibcSymbol &symbol) {
+    std::span<const uint8_t> buildId(symbol.buildId, symbol.buildIdSize);
 
-    if (strcmp(oldValue, value) == 0) {
-        if (DEBUG) LOGD("[%s]: %s (unchanged)", name, oldValue);
-    } else {
-        LOGD("[%s]: %s -> %s", name, oldValue, value);
+    if (void *ptr = libcSymbolAddress(buildId, symbol.offset)) {
+        LOGD("Found " HOOK_TARGET " at the offset the companion sent");
+        return ptr;
     }
 
-    return o_callback(cookie, name, value, serial);
-}
+    if (!buildId.empty()) LOGD("Companion's libc differs from ours, resolving " HOOK_TARGET);
 
-static void (*o_system_property_read_callback)(prop_info *, T_Callback, void *) = nullptr;
+    if (void *ptr = findLibcSymbol(HOOK_TARGET)) return ptr;
 
-static void my_system_property_read_callback(prop_info *pi, T_Callback callback, void *cookie) {
-    if (pi && callback && cookie) o_callback = callback;
-    return o_system_property_read_callback(pi, modify_callback, cookie);
+    LOGE("Couldn't find " HOOK_TARGET " in " LIBC_NAME ", asking Dobby");
+    return DobbySymbolResolver(nullptr, HOOK_TARGET);
 }
 
-static bool doHook() {
-    void *ptr = DobbySymbolResolver(nullptr, "__system_property_read_callback");
-
-    if (ptr && DobbyHook(ptr, (void *) my_system_property_read_callback,
-                         (void **) &o_system_property_read_callback) == 0) {
-        LOGD("hook __system_property_read_callback successful at %p", ptr);
+static bool doHook(HookState *state, void *ptr) {
+    if (ptr && DobbyHook(ptr, (void *) state->replacement, (void **) &state->original) == 0) {
+        LOGD("hook " HOOK_TARGET " successful at %p", ptr);
         return true;
     }
 
-    LOGE("hook __system_property_read_callback failed!");
+    LOGE("hook " HOOK_TARGET " failed!");
     return false;
 }
 
@@ -135,24 +179,7 @@ public:
 
     void preAppSpecialize(zygisk::AppSpecializeArgs *args) override {
 
-        std::string dir, name;
-
-        auto rawDir = env->GetStringUTFChars(args->app_data_dir, nullptr);
-
-        if (rawDir) {
-            dir = rawDir;
-            env->ReleaseStringUTFChars(args->app_data_dir, rawDir);
-        }
-
-        auto rawName = env->GetStringUTFChars(args->nice_name, nullptr);
-
-        if (rawName) {
-            name = rawName;
-            env->ReleaseStringUTFChars(args->nice_name, rawName);
-        }
-
-        bool isGms = dir.ends_with("/com.google.android.gms");
-        bool isGmsUnstable = isGms && name == "com.google.android.gms.unstable";
+        bool isGms = jstringEndsWith(env, args->app_data_dir, "/com.google.android.gms");
 
         if (!isGms) {
             api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
@@ -161,171 +188,352 @@ public:
 
         api->setOption(zygisk::FORCE_DENYLIST_UNMOUNT);
 
-        if (!isGmsUnstable) {
+        if (!jstringEquals(env, args->nice_name, "com.google.android.gms.unstable")) {
             api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
             return;
         }
 
-        int fd = api->connectCompanion();
-
-        size_t dexSize = 0, jsonSize = 0;
-        std::string jsonStr;
+        atraceEnabled = ATrace_isEnabled();
 
-        xread(fd, &dexSize, sizeof(size_t));
-        xread(fd, &jsonSize, sizeof(size_t));
+        int64_t start = nowNs();
+        int64_t deadline = start + COMPANION_TIMEOUT_MS * 1000000LL;
 
-        if (dexSize > 0) {
-            dexVector.resize(dexSize);
-            xread(fd, dexVector.data(), dexSize);
+        int fd;
+        {
+            PhaseTimer timer(PHASE_CONNECT_COMPANION);
+            fd = api->connectCompanion();
         }
 
-        if (jsonSize > 0) {
-            jsonStr.resize(jsonSize);
-            jsonSize = xread(fd, jsonStr.data(), jsonSize);
-            json = nlohmann::json::parse(jsonStr, nullptr, false, true);
+        CompanionMessage message;
+        CompanionFds fds;
+        bool received;
+        {
+            PhaseTimer timer(PHASE_COMPANION_IO);
+            ModuleRequest request;
+            request.request = REQUEST_CONFIG;
+            received = sendRequest(fd, request, deadline) &&
+                       recvMessage(fd, arena, message, fds, deadline);
         }
 
-        bool trickyStore = false;
-        xread(fd, &trickyStore, sizeof(bool));
+        if (!received) {
+            // Never stall specialization on a stuck companion, just don't spoof this time
+            LOGE("Couldn't receive data from companion within %d ms, skipping!",
+                 COMPANION_TIMEOUT_MS);
+            if (fds.dex >= 0) close(fds.dex);
+            if (fds.hook >= 0) close(fds.hook);
+            if (fds.stats >= 0) close(fds.stats);
+            if (fds.reports >= 0) close(fds.reports);
+            if (fd >= 0) close(fd);
+            dlclose();
+            return;
+        }
 
-        bool testSignedRom = false;
-        xread(fd, &testSignedRom, sizeof(bool));
+        roundTripUs = static_cast<uint32_t>((nowNs() - start) / 1000);
 
         close(fd);
 
+        if (fds.dex >= 0) {
+            if (message.dexSize > 0 && message.dexSize <= SIZE_MAX) {
+                dexSize = message.dexSize;
+                dexMap = mmap(nullptr, dexSize, PROT_READ, MAP_PRIVATE, fds.dex, 0);
+                if (dexMap == MAP_FAILED) {
+                    LOGE("Couldn't mmap dex file!");
+                    dexMap = nullptr;
+                    dexSize = 0;
+                }
+            }
+            close(fds.dex);
+        }
+
+        loadHookStub(fds.hook);
+
+        if (!message.libcBuildId.empty()) {
+            std::ranges::copy(message.libcBuildId, libcSymbol.buildId);
+            libcSymbol.buildIdSize = message.libcBuildId.size();
+            libcSymbol.offset = message.libcOffset;
+        }
+
+        PhaseTimer timer(PHASE_PARSE_CONFIG);
+
+        hasConfig = !message.config.empty() && parseConfig(message.config, config);
+
+        if (!message.config.empty() && !hasConfig) {
+            LOGE("Companion sent a malformed config!");
+        }
+
+        if (message.status != CONFIG_STATUS_OK) {
+            LOGE("Config status: %s, see " DIAGNOSTICS_PATH,
+                 configStatusName(static_cast<ConfigStatus>(message.status)));
+        }
+
         LOGD("Dex file size: %zu", dexSize);
-        LOGD("Json file size: %zu", jsonSize);
+        LOGD("Config size: %zu", message.config.size());
 
-        parseJSON();
+        if (hasConfig) {
+            applyConfig(message.flags);
+        }
 
-        if (trickyStore) {
-            LOGD("TrickyStore module detected!");
-            spoofProvider = false;
-            spoofProps = false;
+        // Like the dex, mapped right away because fds opened here may not survive specialization
+        if (fds.stats >= 0) {
+            if (hasConfig && spoofProps) mapStats(fds.stats, message.statsSize);
+            close(fds.stats);
         }
 
-        if (testSignedRom) {
-            LOGD("--- ROM IS SIGNED WITH TEST KEYS ---");
-            spoofSignature = true;
+        // Only filled in by postAppSpecialize, which returns early without a config
+        if (fds.reports >= 0) {
+            if (hasConfig) mapReports(fds.reports, message.reportsSize);
+            close(fds.reports);
         }
     }
 
     void postAppSpecialize(const zygisk::AppSpecializeArgs *args) override {
-        if (dexVector.empty() || json.empty())
+        if (!hasConfig) {
+            releaseTransient();
+            dlclose();
             return;
+        }
 
-        UpdateBuildFields();
+        {
+            PhaseTimer timer(PHASE_UPDATE_BUILD_FIELDS);
+            UpdateBuildFields();
+        }
 
         if (spoofProvider || spoofSignature) {
-            injectDex();
+            if (dexMap) {
+                injectDex();
+            } else {
+                LOGE("Dex file is missing, it can't be injected!");
+            }
         } else {
             LOGD("Dex file won't be injected due spoofProvider and spoofSignature are false");
         }
 
         if (spoofProps) {
-            if (!doHook()) {
+            void *target;
+            {
+                PhaseTimer timer(PHASE_RESOLVE_HOOK);
+                target = resolveHookTarget(libcSymbol);
+            }
+
+            bool hooked;
+            {
+                PhaseTimer timer(PHASE_DO_HOOK);
+                hooked = doHook(hook, target);
+            }
+            if (!hooked) {
+                unmapStats();
+                unmapProps();
+            }
+
+            // Once the stub holds the hook, nothing in this library is needed anymore
+            if (!hooked || hookStub) {
                 dlclose();
             }
         } else {
             dlclose();
         }
 
-        json.clear();
+        // Whatever was read over and over during specialization, the hook keeps summarizing
+        // on its own afterwards
+        moduleLog.flush();
+        hook->flushLog();
+
+        reportTrace();
 
-        dexVector.clear();
-        dexVector.shrink_to_fit();
+        releaseTransient();
     }
 
     void preServerSpecialize(zygisk::ServerSpecializeArgs *args) override {
+        // system_server starts before any app, a good time for the companion to load pif.json,
+        // the dex and the otacerts.zip scan. Nothing comes back, so this never waits on it.
+        int fd = api->connectCompanion();
+
+        if (fd >= 0) {
+            ModuleRequest request;
+            request.request = REQUEST_WARM_UP;
+            if (!sendRequest(fd, request, deadlineAfterMs(COMPANION_TIMEOUT_MS))) {
+                LOGE("Couldn't ask companion to warm up!");
+            }
+            close(fd);
+        }
+
         api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
     }
 
 private:
     zygisk::Api *api = nullptr;
     JNIEnv *env = nullptr;
-    std::vector<char> dexVector;
-    nlohmann::json json;
+    void *dexMap = nullptr;
+    size_t dexSize = 0;
+    // Holds the companion message, and so config, until postAppSpecialize is done
+    Arena arena{ARENA_SIZE};
+    uint32_t roundTripUs = 0;
+    ConfigView config;
+    bool hasConfig = false;
     bool spoofProps = true;
     bool spoofProvider = true;
     bool spoofSignature = false;
+    HookState *hook = nullptr;
+    bool hookStub = false;
+    LaunchReports *reports = nullptr;
+    // Where the companion found HOOK_TARGET, empty build ID when it didn't
+    LibcSymbol libcSymbol{};
+
+    void releaseTransient() {
+        hasConfig = false;
+        config = {};
+        arena.release();
+
+        if (dexMap) {
+            munmap(dexMap, dexSize);
+            dexMap = nullptr;
+            dexSize = 0;
+        }
+    }
 
     void dlclose() {
         LOGD("dlclose zygisk lib");
         api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
     }
 
-    void parseJSON() {
-        if (json.empty()) return;
+    // The mapping outlives this library along with the hook, it's only unmapped when hooking
+    // fails
+    void mapStats(int fd, uint64_t size) {
+        if (size != sizeof(PropStats)) return;
 
-        if (json.contains("DEVICE_INITIAL_SDK_INT")) {
-            if (json["DEVICE_INITIAL_SDK_INT"].is_string()) {
-                DEVICE_INITIAL_SDK_INT = json["DEVICE_INITIAL_SDK_INT"].get<std::string>();
-            } else if (json["DEVICE_INITIAL_SDK_INT"].is_number_integer()) {
-                DEVICE_INITIAL_SDK_INT = std::to_string(json["DEVICE_INITIAL_SDK_INT"].get<int>());
-            } else {
-                LOGE("Couldn't parse DEVICE_INITIAL_SDK_INT value!");
-            }
-            json.erase("DEVICE_INITIAL_SDK_INT");
-        }
+        void *map = mmap(nullptr, sizeof(PropStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
-        if (json.contains("spoofProvider") && json["spoofProvider"].is_boolean()) {
-            spoofProvider = json["spoofProvider"].get<bool>();
-            json.erase("spoofProvider");
+        if (map == MAP_FAILED) {
+            LOGE("Couldn't mmap property stats!");
+        } else if (isPropStats(map, sizeof(PropStats))) {
+            hook->stats = static_cast<PropStats *>(map);
+        } else {
+            munmap(map, sizeof(PropStats));
         }
+    }
 
-        if (json.contains("spoofProps") && json["spoofProps"].is_boolean()) {
-            spoofProps = json["spoofProps"].get<bool>();
-            json.erase("spoofProps");
-        }
+    void mapReports(int fd, uint64_t size) {
+        if (size != sizeof(LaunchReports)) return;
 
-        if (json.contains("spoofSignature") && json["spoofSignature"].is_boolean()) {
-            spoofSignature = json["spoofSignature"].get<bool>();
-            json.erase("spoofSignature");
-        }
+        void *map = mmap(nullptr, sizeof(LaunchReports), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                         0);
 
-        if (json.contains("DEBUG") && json["DEBUG"].is_boolean()) {
-            DEBUG = json["DEBUG"].get<bool>();
-            json.erase("DEBUG");
+        if (map == MAP_FAILED) {
+            LOGE("Couldn't mmap launch reports!");
+        } else if (isLaunchReports(map, sizeof(LaunchReports))) {
+            reports = static_cast<LaunchReports *>(map);
+        } else {
+            munmap(map, sizeof(LaunchReports));
         }
+    }
 
-        if (json.contains("FINGERPRINT") && json["FINGERPRINT"].is_string()) {
-            std::string fingerprint = json["FINGERPRINT"].get<std::string>();
+    void unmapStats() {
+        if (!hook->stats) return;
 
-            std::vector<std::string> vector;
-            auto parts = fingerprint | std::views::split('/');
+        munmap(hook->stats, sizeof(PropStats));
+        hook->stats = nullptr;
+    }
 
-            for (const auto &part: parts) {
-                auto subParts = std::string(part.begin(), part.end()) | std::views::split(':');
-                for (const auto &subPart: subParts) {
-                    vector.emplace_back(subPart.begin(), subPart.end());
-                }
+    // Falls back to the hook built into this library, which then has to stay loaded
+    void loadHookStub(int fd) {
+        if (fd >= 0) {
+            android_dlextinfo info{};
+            info.flags = ANDROID_DLEXT_USE_LIBRARY_FD;
+            info.library_fd = fd;
+
+            void *handle = android_dlopen_ext(HOOK_STUB_NAME, RTLD_NOW | RTLD_LOCAL, &info);
+            close(fd);
+
+            auto getState = handle ? reinterpret_cast<HookState *(*)()>(
+                    dlsym(handle, HOOK_STATE_SYMBOL)) : nullptr;
+
+            if (getState) {
+                hook = getState();
+                hookStub = true;
+                return;
             }
 
-            if (vector.size() == 8) {
-                json["BRAND"] = vector[0];
-                json["PRODUCT"] = vector[1];
-                json["DEVICE"] = vector[2];
-                json["RELEASE"] = vector[3];
-                json["ID"] = vector[4];
-                json["INCREMENTAL"] = vector[5];
-                json["TYPE"] = vector[6];
-                json["TAGS"] = vector[7];
-            } else {
-                LOGE("Error parsing fingerprint values!");
+            LOGE("Couldn't load " HOOK_STUB_NAME ": %s", dlerror());
+        }
+
+        hook = pifHookState();
+        hookStub = false;
+    }
+
+    // Left in the shared region, the companion picks it up on the next config request
+    void reportTrace() {
+        char line[512];
+        int len = snprintf(line, sizeof(line), "Startup trace: companion round trip %u us",
+                           roundTripUs);
+
+        LaunchReport report;
+        report.roundTripUs = roundTripUs;
+        report.arenaPeak = static_cast<uint32_t>(arena.peak());
+        report.phaseCount = PHASE_COUNT;
+
+        for (size_t i = 0; i < PHASE_COUNT; ++i) {
+            auto us = static_cast<uint32_t>(phaseNs[i] / 1000);
+            report.phaseUs[i] = us;
+
+            if (len > 0 && static_cast<size_t>(len) < sizeof(line)) {
+                len += snprintf(line + len, sizeof(line) - len, ", %s %u us", PHASE_NAMES[i], us);
             }
         }
 
-        if (json.contains("SECURITY_PATCH") && json["SECURITY_PATCH"].is_string()) {
-            SECURITY_PATCH = json["SECURITY_PATCH"].get<std::string>();
+        if (len > 0 && static_cast<size_t>(len) < sizeof(line)) {
+            snprintf(line + len, sizeof(line) - len, ", arena peak %zu bytes", arena.peak());
         }
 
-        if (json.contains("ID") && json["ID"].is_string()) {
-            BUILD_ID = json["ID"].get<std::string>();
+        LOGD("%s", line);
+
+        if (!reports) return;
+
+        if (!postLaunchReport(*reports, report)) LOGE("No room left for the launch report!");
+
+        munmap(reports, sizeof(LaunchReports));
+        reports = nullptr;
+    }
+
+    void applyConfig(uint32_t flags) {
+        spoofProps = flags & CONFIG_SPOOF_PROPS;
+        spoofProvider = flags & CONFIG_SPOOF_PROVIDER;
+        spoofSignature = flags & CONFIG_SPOOF_SIGNATURE;
+        hook->debug = flags & CONFIG_DEBUG;
+
+        if (spoofProps) mapProps();
+    }
+
+    // Like the stats, the copy outlives this library along with the hook and is only unmapped
+    // when hooking fails
+    void mapProps() {
+        void *map = mmap(nullptr, config.props.size(), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (map == MAP_FAILED) {
+            LOGE("Couldn't mmap the property rules!");
+            return;
         }
+
+        // parseConfig() already checked the matcher
+        memcpy(map, config.props.data(), config.props.size());
+        mprotect(map, config.props.size(), PROT_READ);
+
+        hook->props = static_cast<const uint8_t *>(map);
+        hook->propsSize = config.props.size();
+    }
+
+    void unmapProps() {
+        if (!hook->props) return;
+
+        munmap(const_cast<uint8_t *>(hook->props), hook->propsSize);
+        hook->props = nullptr;
+        hook->propsSize = 0;
     }
 
     void injectDex() {
-        LOGD("get system classloader");
+        PhaseTimer createTimer(PHASE_CREATE_CLASS_LOADER);
+
+        moduleLog.log("get system classloader");
         auto clClass = env->FindClass("java/lang/ClassLoader");
         auto getSystemClassLoader = env->GetStaticMethodID(clClass, "getSystemClassLoader",
                                                            "()Ljava/lang/ClassLoader;");
@@ -337,12 +545,11 @@ private:
             return;
         }
 
-        LOGD("create class loader");
+        moduleLog.log("create class loader");
         auto dexClClass = env->FindClass("dalvik/system/InMemoryDexClassLoader");
         auto dexClInit = env->GetMethodID(dexClClass, "<init>",
                                           "(Ljava/nio/ByteBuffer;Ljava/lang/ClassLoader;)V");
-        auto buffer = env->NewDirectByteBuffer(dexVector.data(),
-                                               static_cast<jlong>(dexVector.size()));
+        auto buffer = env->NewDirectByteBuffer(dexMap, static_cast<jlong>(dexSize));
         auto dexCl = env->NewObject(dexClClass, dexClInit, buffer, systemClassLoader);
 
         if (env->ExceptionCheck()) {
@@ -351,7 +558,10 @@ private:
             return;
         }
 
-        LOGD("load class");
+        createTimer.stop();
+        PhaseTimer loadTimer(PHASE_LOAD_CLASS);
+
+        moduleLog.log("load class");
         auto loadClass = env->GetMethodID(clClass, "loadClass",
                                           "(Ljava/lang/String;)Ljava/lang/Class;");
         auto entryClassName = env->NewStringUTF("es.chiteroman.playintegrityfix.EntryPoint");
@@ -364,9 +574,12 @@ private:
             return;
         }
 
-        LOGD("call init");
+        loadTimer.stop();
+        PhaseTimer initTimer(PHASE_ENTRY_POINT_INIT);
+
+        moduleLog.log("call init");
         auto entryInit = env->GetStaticMethodID(entryPointClass, "init", "(Ljava/lang/String;ZZ)V");
-        auto jsonStr = env->NewStringUTF(json.dump().c_str());
+        auto jsonStr = env->NewStringUTF(config.javaJson);
         env->CallStaticVoidMethod(entryPointClass, entryInit, jsonStr, spoofProvider,
                                   spoofSignature);
 
@@ -375,6 +588,8 @@ private:
             env->ExceptionClear();
         }
 
+        initTimer.stop();
+
         env->DeleteLocalRef(entryClassName);
         env->DeleteLocalRef(entryClassObj);
         env->DeleteLocalRef(jsonStr);
@@ -383,45 +598,32 @@ private:
         env->DeleteLocalRef(dexClClass);
         env->DeleteLocalRef(clClass);
 
-        LOGD("jni memory free");
+        moduleLog.log("jni memory free");
     }
 
     void UpdateBuildFields() {
-        jclass buildClass = env->FindClass("android/os/Build");
-        jclass versionClass = env->FindClass("android/os/Build$VERSION");
+        jclass classes[] = {env->FindClass("android/os/Build"), env->FindClass("android/os/Build$VERSION")};
 
-        for (auto &[key, val]: json.items()) {
-            if (!val.is_string()) continue;
-
-            const char *fieldName = key.c_str();
-
-            jfieldID fieldID = env->GetStaticFieldID(buildClass, fieldName, "Ljava/lang/String;");
+        forEachConfigField(config, [&](const BuildField &field, const char *value) {
+            jclass clazz = classes[field.owner];
+            jfieldID fieldID = env->GetStaticFieldID(clazz, field.name, field.signature);
 
+            // Fields from newer SDKs are missing on older ones
             if (env->ExceptionCheck()) {
                 env->ExceptionClear();
-
-                fieldID = env->GetStaticFieldID(versionClass, fieldName, "Ljava/lang/String;");
-
-                if (env->ExceptionCheck()) {
-                    env->ExceptionClear();
-                    continue;
-                }
+                return;
             }
 
-            if (fieldID != nullptr) {
-                std::string str = val.get<std::string>();
-                const char *value = str.c_str();
-                jstring jValue = env->NewStringUTF(value);
-
-                env->SetStaticObjectField(buildClass, fieldID, jValue);
-                if (env->ExceptionCheck()) {
-                    env->ExceptionClear();
-                    continue;
-                }
+            jstring jValue = env->NewStringUTF(value);
 
-                LOGD("Set '%s' to '%s'", fieldName, value);
+            env->SetStaticObjectField(clazz, fieldID, jValue);
+            if (env->ExceptionCheck()) {
+                env->ExceptionClear();
+                return;
             }
-        }
+
+            moduleLog.log("Set '%s' to '%s'", field.name, value);
+        });
     }
 };
 
@@ -442,64 +644,781 @@ static std::vector<char> readFile(const char *path) {
     return vector;
 }
 
+// A sealed in-memory copy of a module file, the app process can't open /data/adb itself
+static int createSealedFd(const char *path, const char *name) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) return -1;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    int memfd = static_cast<int>(syscall(__NR_memfd_create, name,
+                                         MFD_CLOEXEC | MFD_ALLOW_SEALING));
+
+    // Kernels without memfd support get the file itself, still read-only
+    if (memfd < 0) return fd;
+
+    off_t offset = 0;
+    while (offset < st.st_size) {
+        ssize_t ret = sendfile(memfd, fd, &offset, st.st_size - offset);
+        if (ret <= 0) {
+            close(memfd);
+            return fd;
+        }
+    }
+
+    close(fd);
+
+    fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+
+    return memfd;
+}
+
+static std::span<const uint8_t> mapFile(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) return {};
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return {};
+    }
+
+    size_t size = st.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) return {};
+
+    return {static_cast<const uint8_t *>(map), size};
+}
+
+static void unmapFile(std::span<const uint8_t> map) {
+    if (!map.empty()) munmap(const_cast<uint8_t *>(map.data()), map.size());
+}
+
 static bool checkOtaZip() {
-    std::array<char, 256> buffer{};
-    std::string result;
-    bool found = false;
-
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(
-            popen("unzip -l /system/etc/security/otacerts.zip", "r"), pclose);
-    if (!pipe) return false;
-
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
-        if (result.find("test") != std::string::npos) {
-            found = true;
+    auto map = mapFile(OTA_CERTS_PATH);
+
+    if (map.empty()) return false;
+
+    bool found = zipHasEntryContaining(map.data(), map.size(), "test");
+
+    unmapFile(map);
+
+    return found;
+}
+
+struct Snapshot {
+    int dexFd = -1;
+    size_t dexSize = 0;
+    int hookFd = -1;
+    size_t hookSize = 0;
+    std::vector<uint8_t> config;
+    uint32_t flags = 0;
+    ConfigStatus status = CONFIG_STATUS_MISSING;
+
+    ~Snapshot() {
+        if (dexFd >= 0) close(dexFd);
+        if (hookFd >= 0) close(hookFd);
+    }
+};
+
+static const char *findJson() {
+    if (std::filesystem::exists(CUSTOM_JSON)) return CUSTOM_JSON;
+    if (std::filesystem::exists(CUSTOM_JSON_FORK)) return CUSTOM_JSON_FORK;
+    if (std::filesystem::exists(DEFAULT_JSON)) return DEFAULT_JSON;
+    return nullptr;
+}
+
+static bool isNewer(const struct stat &a, const struct stat &b) {
+    if (a.st_mtim.tv_sec != b.st_mtim.tv_sec) return a.st_mtim.tv_sec > b.st_mtim.tv_sec;
+    return a.st_mtim.tv_nsec > b.st_mtim.tv_nsec;
+}
+
+static std::vector<uint8_t> readBin(const char *path) {
+    auto map = mapFile(path);
+    std::vector<uint8_t> config;
+
+    ConfigView view;
+    if (map.size() <= PROTOCOL_MAX_PAYLOAD && parseConfig(map, view)) {
+        config.assign(map.begin(), map.end());
+    }
+
+    unmapFile(map);
+
+    return config;
+}
+
+static void writeBin(const std::string &path, const std::vector<uint8_t> &config) {
+    std::string tmp = path + ".tmp";
+
+    FILE *file = fopen(tmp.c_str(), "wb");
+
+    if (!file) return;
+
+    bool written = fwrite(config.data(), 1, config.size(), file) == config.size();
+
+    if (fclose(file) == 0 && written && rename(tmp.c_str(), path.c_str()) == 0) {
+        LOGD("Compiled %s", path.c_str());
+    } else {
+        unlink(tmp.c_str());
+    }
+}
+
+using SourceDiagnostics = std::pair<std::string, ConfigDiagnostics>;
+
+// Read by the WebUI, rewritten whenever a pif.json gets compiled
+static void writeDiagnostics(const std::vector<SourceDiagnostics> &sources) {
+    FILE *file = fopen(DIAGNOSTICS_PATH ".tmp", "w");
+
+    if (!file) return;
+
+    for (auto &[source, diagnostics]: sources) {
+        fprintf(file, "%s: %s\n", source.c_str(), configStatusName(diagnostics.status));
+        for (auto &message: diagnostics.messages) {
+            fprintf(file, "  %s\n", message.c_str());
+        }
+    }
+
+    fclose(file);
+    rename(DIAGNOSTICS_PATH ".tmp", DIAGNOSTICS_PATH);
+}
+
+static bool isProfileFile(std::string_view name) {
+    return name.size() > 5 && name.ends_with(".json");
+}
+
+// Only compares the store with the directory, so it catches profiles being added, removed or
+// renamed (which is how editors that save atomically write them) but not edits in place.
+// Cheap enough to run on every connection.
+static bool profileStoreIsOutdated(struct stat &storeStat) {
+    struct stat dirStat{};
+
+    if (stat(PROFILES_STORE, &storeStat) != 0 || stat(PROFILES_DIR, &dirStat) != 0 ||
+        !isNewer(storeStat, dirStat))
+        return true;
+
+    auto store = mapFile(PROFILES_STORE);
+    uint32_t count = profileCount(store);
+    unmapFile(store);
+
+    return count == 0;
+}
+
+// Also stats every profile, so it's only run by the watcher thread
+static bool profileStoreIsStale() {
+    struct stat storeStat{}, st{};
+
+    if (profileStoreIsOutdated(storeStat)) return true;
+
+    DIR *dir = opendir(PROFILES_DIR);
+
+    if (!dir) return true;
+
+    bool stale = false;
+
+    while (dirent *entry = readdir(dir)) {
+        if (!isProfileFile(entry->d_name)) continue;
+
+        std::string path = std::string(PROFILES_DIR "/") + entry->d_name;
+
+        if (stat(path.c_str(), &st) != 0 || !isNewer(storeStat, st)) {
+            stale = true;
             break;
         }
     }
 
-    return found;
+    closedir(dir);
+
+    return stale;
 }
 
-static void companion(int fd) {
+// False when there are no profiles to compile
+static bool compileProfileStore() {
+    DIR *dir = opendir(PROFILES_DIR);
+
+    if (!dir) return false;
+
+    std::vector<ProfileSource> profiles;
+    std::vector<SourceDiagnostics> sources;
+
+    while (dirent *entry = readdir(dir)) {
+        std::string_view file(entry->d_name);
+
+        if (!isProfileFile(file)) continue;
+
+        std::string path = std::string(PROFILES_DIR "/").append(file);
+        auto json = readFile(path.c_str());
+        auto &[source, diagnostics] = sources.emplace_back(path, ConfigDiagnostics());
+        auto config = compileConfig(json, diagnostics);
+
+        if (config.empty()) {
+            LOGE("Profile %s is not usable, skipping it", source.c_str());
+            continue;
+        }
+
+        profiles.push_back({std::string(file.substr(0, file.size() - 5)), std::move(config)});
+    }
+
+    closedir(dir);
+
+    std::sort(profiles.begin(), profiles.end(), [](const auto &a, const auto &b) {
+        return a.name < b.name;
+    });
+
+    std::sort(sources.begin(), sources.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    writeBin(PROFILES_STORE, buildProfileStore(profiles));
+    writeDiagnostics(sources);
+
+    return true;
+}
+
+// Moves to the next profile on every boot, the companion may be restarted within one
+static uint32_t roundRobinIndex(uint32_t count) {
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
+
+    char bootId[64] = {}, savedBootId[64] = {};
+    unsigned index = 0;
+
+    int fd = open(BOOT_ID_PATH, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t len = read(fd, bootId, sizeof(bootId) - 1);
+        bootId[len > 0 ? strcspn(bootId, "\n") : 0] = 0;
+        close(fd);
+    }
+
+    FILE *file = fopen(PROFILES_STATE, "r");
+    bool saved = file && fscanf(file, "%63s %u", savedBootId, &index) == 2;
+    if (file) fclose(file);
+
+    if (saved && strcmp(bootId, savedBootId) == 0) return index % count;
+
+    index = saved ? (index + 1) % count : 0;
+
+    file = fopen(PROFILES_STATE, "w");
+    if (file) {
+        fprintf(file, "%s %u\n", bootId, index);
+        fclose(file);
+    }
+
+    return index;
+}
+
+static std::string_view trim(std::string_view str) {
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) return {};
+    return str.substr(start, str.find_last_not_of(" \t\r\n") - start + 1);
+}
+
+// Picks a profile as PROFILES_SELECTION says, one of
+//   pinned <key>     the profile with that file name, PRODUCT or MODEL
+//   fallback <key>   the same, or the first profile when that one is missing or broken
+//   round-robin      the next profile on every boot
+// Only the chosen record is read from the store, which is never compiled here. Empty when
+// pif.json should be used instead.
+static std::vector<uint8_t> selectProfile() {
+    auto selection = readFile(PROFILES_SELECTION);
+
+    if (selection.empty()) return {};
+
+    std::string_view line(selection.data(), selection.size());
+    line = trim(line.substr(0, line.find('\n')));
+
+    std::string_view policy = line.substr(0, line.find(' '));
+    std::string_view key = trim(line.substr(policy.size()));
+
+    auto store = mapFile(PROFILES_STORE);
+    uint32_t count = profileCount(store);
+    int64_t index = -1;
+
+    if (count == 0) {
+        LOGE("Profile store is empty or damaged!");
+    } else if (policy == "pinned" || policy == "fallback") {
+        index = findProfile(store, key);
+
+        if (index < 0) {
+            LOGE("Profile '%.*s' not found!", static_cast<int>(key.size()), key.data());
+            if (policy == "fallback") index = 0;
+        }
+    } else if (policy == "round-robin") {
+        index = roundRobinIndex(count);
+    } else {
+        LOGE("Unknown profile policy '%.*s'!", static_cast<int>(policy.size()), policy.data());
+    }
+
+    std::vector<uint8_t> config;
+
+    if (index >= 0) {
+        auto record = profileConfig(store, index);
+
+        ConfigView view;
+        if (parseConfig(record, view)) {
+            config.assign(record.begin(), record.end());
+            LOGD("Using profile %u of %u", static_cast<uint32_t>(index) + 1, count);
+        } else {
+            LOGE("Profile %u is damaged!", static_cast<uint32_t>(index) + 1);
+        }
+    }
+
+    unmapFile(store);
+
+    return config;
+}
 
-    std::vector<char> dex, json;
+// A selected profile wins. Otherwise pif.bin next to the pif.json in use is used as long as
+// it's newer, and regenerated when it isn't. status is only set when there's no config.
+static std::vector<uint8_t> loadConfig(ConfigStatus &status) {
+    auto profile = selectProfile();
 
-    if (std::filesystem::exists(DEX_PATH)) {
-        dex = readFile(DEX_PATH);
+    if (!profile.empty()) return profile;
+
+    const char *jsonPath = findJson();
+
+    if (!jsonPath) {
+        ConfigDiagnostics diagnostics;
+        diagnostics.fail(CONFIG_STATUS_MISSING, "There's no pif.json!");
+        writeDiagnostics({{"pif.json", diagnostics}});
+        status = diagnostics.status;
+        return {};
     }
 
-    if (std::filesystem::exists(CUSTOM_JSON)) {
-        json = readFile(CUSTOM_JSON);
-    } else if (std::filesystem::exists(CUSTOM_JSON_FORK)) {
-        json = readFile(CUSTOM_JSON_FORK);
-    } else if (std::filesystem::exists(DEFAULT_JSON)) {
-        json = readFile(DEFAULT_JSON);
+    std::string binPath(jsonPath);
+    binPath.replace(binPath.size() - 5, 5, ".bin");
+
+    struct stat jsonStat{}, binStat{};
+
+    if (stat(jsonPath, &jsonStat) == 0 && stat(binPath.c_str(), &binStat) == 0 &&
+        isNewer(binStat, jsonStat)) {
+        auto config = readBin(binPath.c_str());
+        if (!config.empty()) return config;
+        LOGD("%s is outdated or damaged, recompiling", binPath.c_str());
     }
 
-    size_t dexSize = dex.size();
-    size_t jsonSize = json.size();
+    auto json = readFile(jsonPath);
+
+    ConfigDiagnostics diagnostics;
+    auto config = compileConfig(json, diagnostics);
+
+    writeDiagnostics({{jsonPath, diagnostics}});
+    status = diagnostics.status;
+
+    if (!config.empty()) writeBin(binPath, config);
+
+    return config;
+}
+
+static std::shared_ptr<const Snapshot> loadSnapshot() {
+    auto snapshot = std::make_shared<Snapshot>();
+
+    auto createFd = [](const char *path, const char *name, int &fd, size_t &size) {
+        fd = createSealedFd(path, name);
+
+        struct stat st{};
+        if (fd >= 0 && fstat(fd, &st) == 0) size = st.st_size;
+    };
+
+    createFd(DEX_PATH, "classes.dex", snapshot->dexFd, snapshot->dexSize);
+    createFd(HOOK_STUB_PATH, HOOK_STUB_NAME, snapshot->hookFd, snapshot->hookSize);
 
-    xwrite(fd, &dexSize, sizeof(size_t));
-    xwrite(fd, &jsonSize, sizeof(size_t));
+    ConfigStatus status = CONFIG_STATUS_INVALID;
+    snapshot->config = loadConfig(status);
 
-    if (dexSize > 0) {
-        xwrite(fd, dex.data(), dexSize);
+    ConfigView config;
+    if (parseConfig(snapshot->config, config)) {
+        snapshot->flags = config.flags;
+        snapshot->status = config.status;
+    } else {
+        snapshot->config.clear();
+        snapshot->status = status;
     }
 
-    if (jsonSize > 0) {
-        xwrite(fd, json.data(), jsonSize);
+    return snapshot;
+}
+
+static std::mutex snapshotMutex;
+static std::shared_ptr<const Snapshot> currentSnapshot;
+
+static void storeSnapshot(std::shared_ptr<const Snapshot> snapshot) {
+    std::lock_guard lock(snapshotMutex);
+    currentSnapshot = std::move(snapshot);
+}
+
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+
+static void watchFiles(int inotifyFd, int moduleWd, int adbWd, int profilesWd) {
+    alignas(inotify_event) char buffer[4096];
+
+    // Compiling hundreds of profiles may take a while, the first snapshot was served without
+    // waiting for it
+    if (profileStoreIsStale() && compileProfileStore()) storeSnapshot(loadSnapshot());
+
+    while (true) {
+        ssize_t len = TEMP_FAILURE_RETRY(read(inotifyFd, buffer, sizeof(buffer)));
+
+        if (len <= 0) break;
+
+        bool changed = false;
+        bool profilesChanged = false;
+
+        for (char *ptr = buffer; ptr < buffer + len;) {
+            auto event = reinterpret_cast<inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                changed = profilesChanged = true;
+                continue;
+            }
+
+            if (event->len == 0) continue;
+
+            std::string_view file(event->name);
+
+            if (event->wd == moduleWd) {
+                changed |= file == "classes.dex" || file == "pif.json" ||
+                           file == "custom.pif.json";
+            } else if (event->wd == adbWd) {
+                changed |= file == "pif.json";
+
+                if (file == PROFILES_NAME) {
+                    changed = profilesChanged = true;
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        profilesWd = inotify_add_watch(inotifyFd, PROFILES_DIR, WATCH_MASK);
+                    }
+                }
+            } else if (event->wd == profilesWd) {
+                changed = profilesChanged = true;
+            }
+        }
+
+        if (profilesChanged) compileProfileStore();
+
+        if (changed) {
+            LOGD("Config files changed, reloading");
+            storeSnapshot(loadSnapshot());
+        }
+    }
+
+    LOGE("inotify watcher stopped!");
+    close(inotifyFd);
+}
+
+static bool startWatcher() {
+    int inotifyFd = inotify_init1(IN_CLOEXEC);
+
+    if (inotifyFd < 0) {
+        LOGE("inotify_init1 failed, files will be read on every connection");
+        return false;
+    }
+
+    int moduleWd = inotify_add_watch(inotifyFd, MODULE_DIR, WATCH_MASK);
+    int adbWd = inotify_add_watch(inotifyFd, CUSTOM_JSON_DIR, WATCH_MASK);
+
+    // Optional, it's watched once it gets created
+    int profilesWd = inotify_add_watch(inotifyFd, PROFILES_DIR, WATCH_MASK);
+
+    if (moduleWd < 0 || adbWd < 0) {
+        LOGE("inotify_add_watch failed, files will be read on every connection");
+        close(inotifyFd);
+        return false;
     }
 
+    // Watches are in place before the first load, so no change can be missed. It uses the
+    // profile store as it is, the watcher thread brings it up to date.
+    storeSnapshot(loadSnapshot());
+
+    std::thread(watchFiles, inotifyFd, moduleWd, adbWd, profilesWd).detach();
+
+    return true;
+}
+
+static std::shared_ptr<const Snapshot> getSnapshot() {
+    static const bool watching = startWatcher();
+
+    if (!watching) {
+        struct stat storeStat{};
+        if (profileStoreIsOutdated(storeStat)) compileProfileStore();
+        return loadSnapshot();
+    }
+
+    std::lock_guard lock(snapshotMutex);
+    return currentSnapshot;
+}
+
+static std::atomic<uint32_t> roundTripHistogram[16];
+
+// Bucket i counts round trips below 2^(i + 7) us, the last one everything slower
+static void recordRoundTrip(uint32_t roundTripUs) {
+    constexpr size_t buckets = std::size(roundTripHistogram);
+
+    size_t bucket = 0;
+    while (bucket < buckets - 1 && roundTripUs >= (1u << (bucket + 7))) {
+        ++bucket;
+    }
+
+    roundTripHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    char line[512];
+    int len = snprintf(line, sizeof(line), "Companion round trip: %u us, histogram:", roundTripUs);
+
+    for (size_t i = 0; i < buckets && len > 0 && static_cast<size_t>(len) < sizeof(line); ++i) {
+        uint32_t count = roundTripHistogram[i].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+
+        if (i == buckets - 1) {
+            len += snprintf(line + len, sizeof(line) - len, " >=%ums:%u",
+                            (1u << (i + 6)) / 1000, count);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, " <%uus:%u", 1u << (i + 7), count);
+        }
+    }
+
+    LOGD("%s", line);
+}
+
+static std::mutex traceMutex;
+static std::deque<std::string> traceHistory;
+static uint32_t launchCount = 0;
+
+// Keeps the last TRACE_HISTORY launch traces in TRACE_PATH for the WebUI
+static void recordTrace(const LaunchReport &report) {
+    char line[512];
+
+    time_t now = time(nullptr);
+    tm local{};
+    localtime_r(&now, &local);
+
+    std::lock_guard lock(traceMutex);
+
+    int len = snprintf(line, sizeof(line), "#%u ", ++launchCount);
+    len += static_cast<int>(strftime(line + len, sizeof(line) - len, "%F %T", &local));
+    len += snprintf(line + len, sizeof(line) - len, " | round trip %u us", report.roundTripUs);
+
+    size_t phases = std::min<size_t>(report.phaseCount, PHASE_COUNT);
+
+    for (size_t i = 0; i < phases && len > 0 && static_cast<size_t>(len) < sizeof(line); ++i) {
+        len += snprintf(line + len, sizeof(line) - len, " | %s %u us", PHASE_NAMES[i],
+                        report.phaseUs[i]);
+    }
+
+    if (len > 0 && static_cast<size_t>(len) < sizeof(line)) {
+        snprintf(line + len, sizeof(line) - len, " | arena peak %u bytes", report.arenaPeak);
+    }
+
+    traceHistory.emplace_back(line);
+    if (traceHistory.size() > TRACE_HISTORY) traceHistory.pop_front();
+
+    FILE *file = fopen(TRACE_PATH ".tmp", "we");
+    if (!file) return;
+
+    for (auto &entry: traceHistory) {
+        fprintf(file, "%s\n", entry.c_str());
+    }
+
+    fclose(file);
+    rename(TRACE_PATH ".tmp", TRACE_PATH);
+}
+
+template<typename T>
+struct SharedRegion {
+    int fd = -1;
+    T *data = nullptr;
+};
+
+// A T in a memfd, mapped here and by every process the fd is sent to
+template<typename T>
+static SharedRegion<T> createSharedRegion(const char *name) {
+    int fd = static_cast<int>(syscall(__NR_memfd_create, name, MFD_CLOEXEC));
+
+    if (fd < 0) return {};
+
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, sizeof(T)) == 0) {
+        map = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    if (map == MAP_FAILED) {
+        LOGE("Couldn't create shared region %s!", name);
+        close(fd);
+        return {};
+    }
+
+    return {fd, new(map) T};
+}
+
+// One region for every process the hook goes to while the companion runs
+static const SharedRegion<PropStats> &propStatsRegion() {
+    static const auto region = createSharedRegion<PropStats>("pif_stats");
+    return region;
+}
+
+// Set once a hook got the stats region, until then there's nothing to summarize
+static std::atomic<bool> propStatsSent{false};
+
+// Likewise shared by every module the companion sends a config to
+static const SharedRegion<LaunchReports> &launchReportsRegion() {
+    static const auto region = createSharedRegion<LaunchReports>("pif_reports");
+    return region;
+}
+
+// Read by the WebUI, rewritten after every launch with what the hooks counted so far
+static void writePropStatsSummary() {
+    if (!propStatsSent.load(std::memory_order_relaxed)) return;
+
+    PropStats *stats = propStatsRegion().data;
+    if (!stats) return;
+
+    FILE *file = fopen(PROP_STATS_PATH ".tmp", "we");
+    if (!file) return;
+
+    writePropStats(*stats, file);
+
+    fclose(file);
+    rename(PROP_STATS_PATH ".tmp", PROP_STATS_PATH);
+}
+
+// Resolved once, the companion's libc doesn't change while it runs
+static const LibcSymbol &libcHookTarget() {
+    static const LibcSymbol symbol = [] {
+        LibcSymbol s{};
+        if (!resolveLibcSymbol(HOOK_TARGET, s)) {
+            LOGE("Couldn't resolve " HOOK_TARGET " in " LIBC_NAME);
+            s.buildIdSize = 0;
+        }
+        return s;
+    }();
+    return symbol;
+}
+
+// otacerts.zip lives on read-only /system, so it can't change until next boot
+static bool isTestSignedRom() {
+    static const bool testSignedRom = checkOtaZip();
+    return testSignedRom;
+}
+
+static void sendConfig(int fd) {
+    auto snapshot = getSnapshot();
+
+    // Only bounds the I/O. REQUEST_WARM_UP has normally loaded the snapshot at boot, if it
+    // didn't get through the first one may take a while.
+    int64_t deadline = deadlineAfterMs(COMPANION_TIMEOUT_MS);
+
+    uint32_t flags = snapshot->flags;
+
     std::string ts(TS_PATH);
     bool trickyStore = std::filesystem::exists(ts) &&
                        !std::filesystem::exists(ts + "/disable") &&
                        !std::filesystem::exists(ts + "/remove");
-    xwrite(fd, &trickyStore, sizeof(bool));
 
-    bool testSignedRom = checkOtaZip();
-    xwrite(fd, &testSignedRom, sizeof(bool));
+    if (trickyStore) {
+        LOGD("TrickyStore module detected!");
+        flags &= ~(CONFIG_SPOOF_PROVIDER | CONFIG_SPOOF_PROPS);
+    }
+
+    if (isTestSignedRom()) {
+        LOGD("--- ROM IS SIGNED WITH TEST KEYS ---");
+        flags |= CONFIG_SPOOF_SIGNATURE;
+    }
+
+    // The module only needs the dex when EntryPoint is going to run
+    bool injectDex = !snapshot->config.empty() &&
+                     (flags & (CONFIG_SPOOF_PROVIDER | CONFIG_SPOOF_SIGNATURE));
+
+    // Likewise the hook stub is only sent when props are going to be spoofed
+    bool sendHook = !snapshot->config.empty() && (flags & CONFIG_SPOOF_PROPS);
+
+    // Timing every read costs several times what the read itself does, so stats are only
+    // counted when pif.json asks for DEBUG
+    int statsFd = (sendHook && (flags & CONFIG_DEBUG)) ? propStatsRegion().fd : -1;
+    bool sendStats = statsFd >= 0;
+
+    if (sendStats) propStatsSent.store(true, std::memory_order_relaxed);
+
+    // Without a config the module unloads before it has anything to report
+    int reportsFd = launchReportsRegion().fd;
+    bool sendReports = !snapshot->config.empty() && reportsFd >= 0;
+
+    CompanionMessage message;
+    message.dexSize = injectDex ? snapshot->dexSize : 0;
+    message.hookSize = sendHook ? snapshot->hookSize : 0;
+    message.statsSize = sendStats ? sizeof(PropStats) : 0;
+    message.reportsSize = sendReports ? sizeof(LaunchReports) : 0;
+    message.config = snapshot->config;
+    message.flags = flags;
+    message.status = snapshot->status;
+
+    // Its libc is the one zygote and so the module have, unless they're different builds
+    const LibcSymbol &hookTarget = libcHookTarget();
+
+    if (sendHook && hookTarget.buildIdSize > 0) {
+        message.libcOffset = hookTarget.offset;
+        message.libcBuildId = {hookTarget.buildId, hookTarget.buildIdSize};
+    }
+
+    CompanionFds fds;
+    fds.dex = injectDex ? snapshot->dexFd : -1;
+    fds.hook = sendHook ? snapshot->hookFd : -1;
+    fds.stats = sendStats ? statsFd : -1;
+    fds.reports = sendReports ? reportsFd : -1;
+
+    if (!sendMessage(fd, fds, message, deadline)) {
+        LOGE("Couldn't send data to module!");
+    }
+}
+
+// What earlier launches left behind, picked up once the module asking now has its config
+static void collectLaunchReports() {
+    LaunchReports *reports = launchReportsRegion().data;
+    if (!reports) return;
+
+    LaunchReport taken[LAUNCH_REPORT_SLOTS];
+    size_t count = takeLaunchReports(*reports, taken);
+
+    for (size_t i = 0; i < count; ++i) {
+        recordRoundTrip(taken[i].roundTripUs);
+        recordTrace(taken[i]);
+    }
+
+    if (count > 0) writePropStatsSummary();
+}
+
+static void companion(int fd) {
+    int64_t deadline = deadlineAfterMs(COMPANION_TIMEOUT_MS);
+
+    std::vector<uint8_t> buffer;
+    ModuleRequest request;
+
+    if (!recvRequest(fd, buffer, request, deadline)) {
+        LOGE("Couldn't receive request from module!");
+        return;
+    }
+
+    switch (request.request) {
+        case REQUEST_CONFIG:
+            sendConfig(fd);
+            collectLaunchReports();
+            break;
+        case REQUEST_WARM_UP:
+            // Everything sendConfig would otherwise load on the first request, inside its deadline
+            getSnapshot();
+            isTestSignedRom();
+            libcHookTarget();
+            launchReportsRegion();
+            LOGD("Companion warmed up");
+            break;
+        default:
+            LOGE("Unknown request %d from module!", request.request);
+            break;
+    }
 }
 
 REGISTER_ZYGISK_MODULE(PlayIntegrityFix)
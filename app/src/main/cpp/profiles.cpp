@@ -0,0 +1,136 @@
+#include <cstring>
+#include "config.hpp"
+#include "profiles.hpp"
+
+static uint32_t keyHash(std::string_view key) {
+    uint32_t hash = 2166136261u;
+    for (char c: key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool keyEquals(std::span<const uint8_t> store, uint32_t offset, std::string_view key) {
+    if (offset >= store.size() || store.size() - offset <= key.size()) return false;
+    return memcmp(store.data() + offset, key.data(), key.size()) == 0 &&
+           store[offset + key.size()] == 0;
+}
+
+std::vector<uint8_t> buildProfileStore(const std::vector<ProfileSource> &profiles) {
+    // At most 3 keys per profile, kept under half full
+    uint32_t slotCount = 8;
+    while (slotCount < profiles.size() * 6) slotCount <<= 1;
+
+    size_t profilesOffset = PROFILE_STORE_HEADER_SIZE;
+    size_t slotsOffset = profilesOffset + profiles.size() * 8;
+    size_t keysOffset = slotsOffset + static_cast<size_t>(slotCount) * 8;
+
+    std::vector<uint8_t> out(keysOffset);
+
+    writeLE<uint32_t>(out.data(), PROFILE_STORE_MAGIC);
+    writeLE<uint16_t>(out.data() + 4, PROFILE_STORE_VERSION);
+    writeLE<uint32_t>(out.data() + 8, profiles.size());
+    writeLE<uint32_t>(out.data() + 12, slotCount);
+
+    auto addKey = [&](std::string_view key, uint32_t index) {
+        if (key.empty()) return;
+
+        uint32_t mask = slotCount - 1;
+
+        for (uint32_t slot = keyHash(key) & mask;; slot = (slot + 1) & mask) {
+            uint8_t *entry = out.data() + slotsOffset + slot * 8;
+            uint32_t offset = readLE<uint32_t>(entry);
+
+            // The first profile with a key keeps it
+            if (offset != 0 && keyEquals(out, offset, key)) return;
+
+            if (offset == 0) {
+                writeLE<uint32_t>(entry, out.size());
+                writeLE<uint32_t>(entry + 4, index);
+                out.insert(out.end(), key.begin(), key.end());
+                out.push_back(0);
+                return;
+            }
+        }
+    };
+
+    for (uint32_t i = 0; i < profiles.size(); ++i) {
+        ConfigView config;
+        if (!parseConfig(profiles[i].config, config)) continue;
+
+        addKey(profiles[i].name, i);
+
+        forEachConfigField(config, [&](const BuildField &field, const char *value) {
+            if (strcmp(field.name, "PRODUCT") == 0 || strcmp(field.name, "MODEL") == 0) {
+                addKey(value, i);
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < profiles.size(); ++i) {
+        out.resize((out.size() + 3) & ~size_t(3));
+
+        uint8_t *entry = out.data() + profilesOffset + i * 8;
+        writeLE<uint32_t>(entry, out.size());
+        writeLE<uint32_t>(entry + 4, profiles[i].config.size());
+
+        out.insert(out.end(), profiles[i].config.begin(), profiles[i].config.end());
+    }
+
+    return out;
+}
+
+uint32_t profileCount(std::span<const uint8_t> store) {
+    if (store.size() < PROFILE_STORE_HEADER_SIZE) return 0;
+
+    if (readLE<uint32_t>(store.data()) != PROFILE_STORE_MAGIC ||
+        readLE<uint16_t>(store.data() + 4) != PROFILE_STORE_VERSION)
+        return 0;
+
+    uint32_t count = readLE<uint32_t>(store.data() + 8);
+    uint32_t slotCount = readLE<uint32_t>(store.data() + 12);
+
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 ||
+        PROFILE_STORE_HEADER_SIZE + (uint64_t(count) + slotCount) * 8 > store.size())
+        return 0;
+
+    return count;
+}
+
+int64_t findProfile(std::span<const uint8_t> store, std::string_view key) {
+    uint32_t count = profileCount(store);
+
+    if (count == 0) return -1;
+
+    uint32_t slotCount = readLE<uint32_t>(store.data() + 12);
+    uint32_t mask = slotCount - 1;
+    const uint8_t *slots = store.data() + PROFILE_STORE_HEADER_SIZE + size_t(count) * 8;
+
+    uint32_t slot = keyHash(key) & mask;
+
+    for (uint32_t probes = 0; probes < slotCount; ++probes, slot = (slot + 1) & mask) {
+        uint32_t offset = readLE<uint32_t>(slots + slot * 8);
+
+        if (offset == 0) break;
+
+        if (keyEquals(store, offset, key)) {
+            uint32_t index = readLE<uint32_t>(slots + slot * 8 + 4);
+            return index < count ? index : -1;
+        }
+    }
+
+    return -1;
+}
+
+std::span<const uint8_t> profileConfig(std::span<const uint8_t> store, uint32_t index) {
+    if (index >= profileCount(store)) return {};
+
+    const uint8_t *entry = store.data() + PROFILE_STORE_HEADER_SIZE + size_t(index) * 8;
+    uint32_t offset = readLE<uint32_t>(entry);
+    uint32_t size = readLE<uint32_t>(entry + 4);
+
+    if (offset > store.size() || size > store.size() - offset) return {};
+
+    return store.subspan(offset, size);
+}
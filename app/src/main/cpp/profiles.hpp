@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Profile store, compiled by the companion from a directory of pif.json files:
+//   header: magic u32, version u16, reserved u16, profile count u32, slot count u32
+//   profiles: per profile, file offset u32 and size u32 of its config record
+//   slots: open addressing table of key offset u32 (0 when empty) and profile index u32
+//   keys: NUL-terminated names the profiles are found by, file name, PRODUCT and MODEL
+//   records: config records as described in config.hpp, 4-byte aligned
+// Finding a profile hashes the key once and touches a single record, however big the store is.
+#define PROFILE_STORE_MAGIC 0x53464950 // PIFS
+#define PROFILE_STORE_VERSION 3
+#define PROFILE_STORE_HEADER_SIZE 16
+
+struct ProfileSource {
+    // File name without .json
+    std::string name;
+    std::vector<uint8_t> config;
+};
+
+std::vector<uint8_t> buildProfileStore(const std::vector<ProfileSource> &profiles);
+
+// 0 when store isn't a profile store
+uint32_t profileCount(std::span<const uint8_t> store);
+
+// Index of the profile with key as its name, PRODUCT or MODEL, -1 if there's none
+int64_t findProfile(std::span<const uint8_t> store, std::string_view key);
+
+// The config record of a profile, empty when index or the record bounds are out of range
+std::span<const uint8_t> profileConfig(std::span<const uint8_t> store, uint32_t index);
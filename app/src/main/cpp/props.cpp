@@ -0,0 +1,302 @@
+#include "bytes.hpp"
+#include "props.hpp"
+
+static bool isPropNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '.' || c == '_' || c == '-' || c == '@' || c == ':';
+}
+
+bool classifyPropPattern(std::string_view pattern, PropRuleKind &kind) {
+    size_t wildcards = 0;
+
+    for (char c: pattern) {
+        if (c == '*' || c == '?') ++wildcards;
+        else if (!isPropNameChar(c)) return false;
+    }
+
+    if (pattern.empty()) return false;
+
+    if (wildcards == 0) kind = PROP_RULE_EXACT;
+    else if (wildcards == 1 && pattern.front() == '*') kind = PROP_RULE_SUFFIX;
+    else if (wildcards == 1 && pattern.back() == '*') kind = PROP_RULE_PREFIX;
+    else kind = PROP_RULE_GLOB;
+
+    return true;
+}
+
+bool globMatch(std::string_view pattern, std::string_view name) {
+    size_t p = 0, n = 0;
+    // Where to retry from when what followed the last * didn't match
+    size_t starP = std::string_view::npos, starN = 0;
+
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+        } else if (starP != std::string_view::npos) {
+            p = starP + 1;
+            n = ++starN;
+        } else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+
+    return p == pattern.size();
+}
+
+static uint32_t nameHash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c: name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t u32At(std::span<const uint8_t> matcher, uint32_t offset) {
+    return readLE<uint32_t>(matcher.data() + offset);
+}
+
+// A NUL-terminated string starting at offset
+static bool isString(std::span<const uint8_t> matcher, uint32_t offset) {
+    return offset >= PROP_MATCHER_HEADER_SIZE && offset < matcher.size();
+}
+
+static bool isNode(std::span<const uint8_t> matcher, uint32_t offset) {
+    uint32_t nodes = u32At(matcher, 16);
+    uint32_t count = u32At(matcher, 20);
+    return offset >= nodes && offset < uint64_t(nodes) + uint64_t(count) * PROP_MATCHER_NODE_SIZE &&
+           (offset - nodes) % PROP_MATCHER_NODE_SIZE == 0;
+}
+
+static bool fits(std::span<const uint8_t> matcher, uint64_t offset, uint64_t size) {
+    return offset <= matcher.size() && size <= matcher.size() - offset;
+}
+
+bool parsePropMatcher(std::span<const uint8_t> matcher) {
+    if (matcher.size() < PROP_MATCHER_HEADER_SIZE || matcher.size() > PROP_MATCHER_MAX ||
+        matcher.back() != 0)
+        return false;
+
+    if (u32At(matcher, 0) != PROP_MATCHER_MAGIC ||
+        readLE<uint16_t>(matcher.data() + 4) != PROP_MATCHER_VERSION ||
+        u32At(matcher, 8) != matcher.size())
+        return false;
+
+    uint32_t slotCount = u32At(matcher, 12);
+    uint32_t nodes = u32At(matcher, 16);
+    uint32_t nodeCount = u32At(matcher, 20);
+
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 ||
+        !fits(matcher, PROP_MATCHER_HEADER_SIZE, uint64_t(slotCount) * PROP_MATCHER_SLOT_SIZE) ||
+        !fits(matcher, nodes, uint64_t(nodeCount) * PROP_MATCHER_NODE_SIZE))
+        return false;
+
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        uint32_t slot = PROP_MATCHER_HEADER_SIZE + i * PROP_MATCHER_SLOT_SIZE;
+        uint32_t name = u32At(matcher, slot + 4);
+
+        if (name == 0) continue;
+
+        if (!isString(matcher, name) || !fits(matcher, name, u32At(matcher, slot + 8)) ||
+            !isString(matcher, u32At(matcher, slot + 12)))
+            return false;
+    }
+
+    if (!isNode(matcher, u32At(matcher, 24)) || !isNode(matcher, u32At(matcher, 28))) return false;
+
+    uint32_t tails = u32At(matcher, 32);
+    uint32_t tailBits = u32At(matcher, 36);
+
+    if (tails != 0 &&
+        (tails < PROP_MATCHER_HEADER_SIZE || tailBits < PROP_TAIL_MIN_BITS ||
+         tailBits > PROP_TAIL_MAX_BITS ||
+         !fits(matcher, tails, (uint64_t(1) << tailBits) * PROP_MATCHER_TAIL_SIZE)))
+        return false;
+
+    for (uint32_t i = 0; tails != 0 && i < (1u << tailBits); ++i) {
+        uint32_t slot = tails + i * PROP_MATCHER_TAIL_SIZE;
+        uint32_t kind = u32At(matcher, slot + 20);
+
+        if (readLE<uint64_t>(matcher.data() + slot) == 0 || kind == PROP_TAIL_SHARED) continue;
+
+        uint32_t literal = u32At(matcher, slot + 8);
+        uint32_t length = u32At(matcher, slot + 12);
+
+        if ((kind != PROP_RULE_EXACT && kind != PROP_RULE_SUFFIX) || length < PROP_TAIL_CHARS ||
+            !isString(matcher, literal) || !fits(matcher, literal, length) ||
+            !isString(matcher, u32At(matcher, slot + 16)))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        uint32_t node = nodes + i * PROP_MATCHER_NODE_SIZE;
+        uint32_t value = u32At(matcher, node);
+        uint32_t globs = u32At(matcher, node + 4);
+        uint32_t edgeCount = u32At(matcher, node + 8);
+        uint32_t edges = u32At(matcher, node + 12);
+
+        if (value != PROP_NO_VALUE && !isString(matcher, value)) return false;
+
+        uint64_t targets = uint64_t(edges) + ((edgeCount + 3) & ~3ull);
+
+        if (!fits(matcher, edges, targets - edges + uint64_t(edgeCount) * PROP_MATCHER_EDGE_SIZE))
+            return false;
+
+        for (uint32_t e = 0; e < edgeCount; ++e) {
+            uint32_t edge = targets + e * PROP_MATCHER_EDGE_SIZE;
+            uint32_t label = u32At(matcher, edge + 4);
+
+            if (!isNode(matcher, u32At(matcher, edge)) || !isString(matcher, label) ||
+                !fits(matcher, label, u32At(matcher, edge + 8)))
+                return false;
+        }
+
+        if (globs == 0) continue;
+
+        if (!fits(matcher, globs, 4)) return false;
+
+        uint32_t globCount = u32At(matcher, globs);
+
+        if (!fits(matcher, globs + 4, uint64_t(globCount) * PROP_MATCHER_GLOB_SIZE)) return false;
+
+        for (uint32_t g = 0; g < globCount; ++g) {
+            uint32_t glob = globs + 4 + g * PROP_MATCHER_GLOB_SIZE;
+            uint32_t pattern = u32At(matcher, glob);
+
+            if (!isString(matcher, pattern) || !fits(matcher, pattern, u32At(matcher, glob + 4)) ||
+                !isString(matcher, u32At(matcher, glob + 8)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Offset of the edge of node starting with c, 0 when there's none
+static uint32_t findEdge(std::span<const uint8_t> matcher, uint32_t node, char c) {
+    uint32_t count = u32At(matcher, node + 8);
+    uint32_t edges = u32At(matcher, node + 12);
+    const uint8_t *chars = matcher.data() + edges;
+    auto key = static_cast<uint8_t>(c);
+
+    uint32_t low = 0, high = count;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (chars[mid] < key) low = mid + 1;
+        else high = mid;
+    }
+
+    if (low == count || chars[low] != key) return 0;
+
+    return edges + ((count + 3) & ~3u) + low * PROP_MATCHER_EDGE_SIZE;
+}
+
+// Walks a trie along name, from its end for the suffix trie. Returns the deepest value found,
+// and the value of the first glob in rule order that matches among those on the way.
+static uint32_t walkTrie(std::span<const uint8_t> matcher, uint32_t node, std::string_view name,
+                         bool reverse, uint32_t &globValue, uint32_t &globOrder) {
+    uint32_t value = PROP_NO_VALUE;
+    size_t matched = 0;
+
+    while (true) {
+        if (u32At(matcher, node) != PROP_NO_VALUE) value = u32At(matcher, node);
+
+        if (uint32_t globs = u32At(matcher, node + 4)) {
+            uint32_t count = u32At(matcher, globs);
+
+            for (uint32_t g = 0; g < count; ++g) {
+                uint32_t glob = globs + 4 + g * PROP_MATCHER_GLOB_SIZE;
+                uint32_t order = u32At(matcher, glob + 12);
+
+                if (order >= globOrder) continue;
+
+                std::string_view pattern(propValue(matcher, u32At(matcher, glob)),
+                                         u32At(matcher, glob + 4));
+
+                if (globMatch(pattern, name)) {
+                    globOrder = order;
+                    globValue = u32At(matcher, glob + 8);
+                }
+            }
+        }
+
+        if (matched == name.size()) break;
+
+        uint32_t edge = findEdge(matcher, node, name[reverse ? name.size() - 1 - matched : matched]);
+        if (!edge) break;
+
+        size_t length = u32At(matcher, edge + 8);
+        if (length > name.size() - matched - 1) break;
+
+        // Labels are stored in name order, the suffix trie's ones end right before what matched
+        size_t from = reverse ? name.size() - matched - 1 - length : matched + 1;
+        std::string_view label(propValue(matcher, u32At(matcher, edge + 4)), length);
+        if (name.substr(from, length) != label) break;
+
+        matched += 1 + length;
+        node = u32At(matcher, edge);
+    }
+
+    return value;
+}
+
+int32_t findPropValue(std::span<const uint8_t> matcher, std::string_view name) {
+    if (uint32_t tails = u32At(matcher, 32)) {
+        // Every rule is at least PROP_TAIL_CHARS long and no NUL-free name has a zero tail
+        if (name.size() < PROP_TAIL_CHARS) return -1;
+
+        auto *end = reinterpret_cast<const uint8_t *>(name.data() + name.size());
+        auto tail = readLE<uint64_t>(end - PROP_TAIL_CHARS);
+        uint32_t slot = tails + propTailSlot(tail, readLE<uint64_t>(matcher.data() + 40),
+                                             u32At(matcher, 36)) * PROP_MATCHER_TAIL_SIZE;
+
+        if (readLE<uint64_t>(matcher.data() + slot) != tail) return -1;
+
+        uint32_t kind = u32At(matcher, slot + 20);
+
+        if (kind != PROP_TAIL_SHARED) {
+            uint32_t length = u32At(matcher, slot + 12);
+
+            if (kind == PROP_RULE_EXACT ? name.size() != length : name.size() < length) return -1;
+
+            // The last PROP_TAIL_CHARS already matched
+            std::string_view head(propValue(matcher, u32At(matcher, slot + 8)),
+                                  length - PROP_TAIL_CHARS);
+            if (name.substr(name.size() - length, head.size()) != head) return -1;
+
+            return static_cast<int32_t>(u32At(matcher, slot + 16));
+        }
+    }
+
+    uint32_t slotCount = u32At(matcher, 12);
+    uint32_t mask = slotCount - 1;
+    uint32_t hash = nameHash(name);
+
+    for (uint32_t probes = 0, i = hash & mask; probes < slotCount; ++probes, i = (i + 1) & mask) {
+        uint32_t slot = PROP_MATCHER_HEADER_SIZE + i * PROP_MATCHER_SLOT_SIZE;
+        uint32_t offset = u32At(matcher, slot + 4);
+
+        if (offset == 0) break;
+
+        if (u32At(matcher, slot) == hash && u32At(matcher, slot + 8) == name.size() &&
+            name == std::string_view(propValue(matcher, offset), name.size()))
+            return static_cast<int32_t>(u32At(matcher, slot + 12));
+    }
+
+    // Only globs anchored on the nodes this name reaches can match it
+    uint32_t globValue = PROP_NO_VALUE, globOrder = UINT32_MAX;
+
+    uint32_t value = walkTrie(matcher, u32At(matcher, 24), name, true, globValue, globOrder);
+    if (value != PROP_NO_VALUE) return static_cast<int32_t>(value);
+
+    value = walkTrie(matcher, u32At(matcher, 28), name, false, globValue, globOrder);
+    if (value != PROP_NO_VALUE) return static_cast<int32_t>(value);
+
+    return globValue == PROP_NO_VALUE ? -1 : static_cast<int32_t>(globValue);
+}
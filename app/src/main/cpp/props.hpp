@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Property rules, compiled by the companion from the built-in rules and the PROPS section of
+// pif.json into a matcher the hook uses in place:
+//   header: magic u32, version u16, reserved u16, size u32, exact slot count u32,
+//           nodes offset u32, node count u32, suffix trie root u32, prefix trie root u32,
+//           tail table offset u32 (0 when none), tail slot bits u32, tail seed u64
+//   exact: open addressing table of name hash u32, name offset u32 (0 when empty),
+//          name length u32 and value offset u32
+//   tails: tail u64 (0 when empty), literal offset u32, literal length u32, value offset u32
+//          and kind u32, PROP_RULE_EXACT, PROP_RULE_SUFFIX or PROP_TAIL_SHARED
+//   nodes: value offset u32 (PROP_NO_VALUE when none), glob list offset u32 (0 when none),
+//          edge count u32 and edges offset u32
+//   edges: per node, its edge chars sorted and padded to 4, then per edge child node offset
+//          u32, label offset u32 and label length u32
+//   globs: per node, count u32 then pattern offset u32, pattern length u32, value offset u32
+//          and rule order u32 of every glob anchored there
+//   strings: NUL-terminated names, patterns and values
+// The suffix trie is walked from the end of a name and the prefix trie from its start, so a
+// lookup costs as much as the name is long, however many rules there are. Chains of nodes with
+// nothing on them are folded into edge labels, the chars following the edge char in name order.
+// Globs hang off the node of their literal tail, or of their literal head when they end with '*'.
+// When every rule is an exact name or a suffix of at least PROP_TAIL_CHARS chars, as the
+// built-in ones are, the tail table settles a lookup on its own. It's indexed by the last 8
+// chars of each name under a seed no two of them collide with, so a name gets one probe and a
+// compare of its last 8 chars rejects almost all of them. Rules that share their last 8 chars
+// are marked PROP_TAIL_SHARED and looked up the long way.
+#define PROP_MATCHER_MAGIC 0x52464950 // PIFR
+#define PROP_MATCHER_VERSION 2
+#define PROP_MATCHER_HEADER_SIZE 48
+#define PROP_MATCHER_SLOT_SIZE 16
+#define PROP_MATCHER_TAIL_SIZE 24
+#define PROP_MATCHER_NODE_SIZE 16
+#define PROP_MATCHER_EDGE_SIZE 12
+#define PROP_MATCHER_GLOB_SIZE 16
+#define PROP_NO_VALUE UINT32_MAX
+
+#define PROP_TAIL_CHARS 8
+#define PROP_TAIL_MIN_BITS 4
+#define PROP_TAIL_MAX_BITS 8
+#define PROP_TAIL_SHARED UINT32_MAX
+
+// The hook keeps its own copy of the matcher
+#define PROP_MATCHER_MAX (64 * 1024)
+
+// Same as PROP_VALUE_MAX
+#define PROP_OVERRIDE_MAX 92
+
+enum PropRuleKind : uint8_t {
+    PROP_RULE_EXACT,
+    // *tail
+    PROP_RULE_SUFFIX,
+    // head*
+    PROP_RULE_PREFIX,
+    // Anything else with * or ?
+    PROP_RULE_GLOB,
+};
+
+struct PropRuleSource {
+    std::string_view pattern;
+    // Empty leaves the properties matched alone
+    std::string_view value;
+};
+
+// Rules every config starts with, pif.json can replace or turn them off by pattern. The values
+// of these three come from DEVICE_INITIAL_SDK_INT, SECURITY_PATCH and ID, they're left out
+// when empty.
+inline constexpr std::string_view PROP_SDK_PATTERN = "*api_level";
+inline constexpr std::string_view PROP_SECURITY_PATCH_PATTERN = "*.security_patch";
+inline constexpr std::string_view PROP_BUILD_ID_PATTERN = "*.build.id";
+
+inline constexpr PropRuleSource PROP_FIXED_RULES[] = {
+        {"init.svc.adbd", "stopped"},
+        {"sys.usb.state", "mtp"},
+};
+
+inline uint32_t propTailSlot(uint64_t tail, uint64_t seed, uint32_t bits) {
+    return static_cast<uint32_t>(((tail ^ seed) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+// False when pattern has chars a property name can't have
+bool classifyPropPattern(std::string_view pattern, PropRuleKind &kind);
+
+// * matches any run of chars and ? a single one
+bool globMatch(std::string_view pattern, std::string_view name);
+
+// Exact names go first, then the longest suffix, the longest prefix and last the first glob in
+// rule order. A later rule replaces an earlier one with the same pattern. Empty when it doesn't
+// fit in PROP_MATCHER_MAX.
+std::vector<uint8_t> buildPropMatcher(std::span<const PropRuleSource> rules);
+
+// Checks every offset once, so lookups can trust the matcher afterwards
+bool parsePropMatcher(std::span<const uint8_t> matcher);
+
+// Offset of the value reported for name, -1 when no rule matches
+int32_t findPropValue(std::span<const uint8_t> matcher, std::string_view name);
+
+inline const char *propValue(std::span<const uint8_t> matcher, int32_t offset) {
+    return reinterpret_cast<const char *>(matcher.data() + offset);
+}
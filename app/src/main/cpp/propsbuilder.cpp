@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+#include "bytes.hpp"
+#include "props.hpp"
+#include "stringpool.hpp"
+
+struct PropTrieEdge {
+    char c;
+    uint32_t child;
+    // The chars after c that lead to child, in name order
+    std::string label;
+};
+
+struct PropTrieNode {
+    uint32_t value = PROP_NO_VALUE;
+    std::vector<PropTrieEdge> edges;
+    // Indexes of the globs anchored here into the rules
+    std::vector<uint32_t> globs;
+};
+
+struct PropTrie {
+    std::vector<PropTrieNode> nodes{1};
+
+    // The node at the end of key, read backwards for the suffix trie
+    uint32_t insert(std::string_view key, bool reverse) {
+        uint32_t node = 0;
+
+        for (size_t i = 0; i < key.size(); ++i) {
+            char c = key[reverse ? key.size() - 1 - i : i];
+            auto &edges = nodes[node].edges;
+            auto edge = std::ranges::find(edges, c, &PropTrieEdge::c);
+
+            if (edge != edges.end()) {
+                node = edge->child;
+            } else {
+                auto child = static_cast<uint32_t>(nodes.size());
+                edges.push_back({c, child, {}});
+                nodes.emplace_back();
+                node = child;
+            }
+        }
+
+        return node;
+    }
+
+    // Folds every run of nodes with a single edge and nothing anchored on them into the label
+    // of the edge leading there, so lookups compare those chars at once
+    void compress(bool reverse) {
+        std::vector<PropTrieNode> kept;
+
+        auto keep = [&](auto &self, uint32_t node) -> uint32_t {
+            auto id = static_cast<uint32_t>(kept.size());
+            kept.push_back({nodes[node].value, {}, std::move(nodes[node].globs)});
+
+            for (auto &edge: nodes[node].edges) {
+                std::string label;
+                uint32_t child = edge.child;
+
+                while (nodes[child].value == PROP_NO_VALUE && nodes[child].globs.empty() &&
+                       nodes[child].edges.size() == 1) {
+                    label.push_back(nodes[child].edges[0].c);
+                    child = nodes[child].edges[0].child;
+                }
+
+                if (reverse) std::ranges::reverse(label);
+
+                uint32_t keptChild = self(self, child);
+                kept[id].edges.push_back({edge.c, keptChild, std::move(label)});
+            }
+
+            return id;
+        };
+
+        keep(keep, 0);
+        nodes = std::move(kept);
+
+        // Sorted the way lookups binary search them. The pool keeps views of the labels, so
+        // they must not move after this.
+        for (auto &node: nodes) {
+            std::ranges::sort(node.edges, {}, [](auto &edge) {
+                return static_cast<uint8_t>(edge.c);
+            });
+        }
+    }
+};
+
+static uint32_t nameHash(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c: name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct PropTail {
+    uint64_t tail;
+    // Index into the exact and suffix rules, or PROP_TAIL_SHARED when several end the same
+    uint32_t rule;
+};
+
+// Seed and slot bits under which every tail gets a slot of its own, false when there are too
+// many tails for PROP_TAIL_MAX_BITS
+static bool findTailSeed(std::span<const PropTail> tails, uint64_t &seed, uint32_t &bits) {
+    uint32_t minBits = PROP_TAIL_MIN_BITS;
+    while ((size_t(1) << minBits) < tails.size() * 2) ++minBits;
+
+    for (bits = minBits; bits <= PROP_TAIL_MAX_BITS; ++bits) {
+        std::vector<bool> used(size_t(1) << bits);
+        seed = 0;
+
+        for (int attempt = 0; attempt < 1024; ++attempt) {
+            // splitmix64, so seeds differ in every bit
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t mixed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+            mixed ^= mixed >> 31;
+
+            std::fill(used.begin(), used.end(), false);
+            bool collided = false;
+
+            for (auto &tail: tails) {
+                uint32_t slot = propTailSlot(tail.tail, mixed, bits);
+                if (used[slot]) {
+                    collided = true;
+                    break;
+                }
+                used[slot] = true;
+            }
+
+            if (!collided) {
+                seed = mixed;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+std::vector<uint8_t> buildPropMatcher(std::span<const PropRuleSource> rules) {
+    // A later rule with the same pattern replaces the earlier one but keeps its order
+    std::vector<PropRuleSource> unique;
+
+    for (auto &rule: rules) {
+        auto same = std::ranges::find(unique, rule.pattern, &PropRuleSource::pattern);
+        if (same != unique.end()) same->value = rule.value;
+        else unique.push_back(rule);
+    }
+
+    // Offsets are relative to where the pool ends up
+    StringPool strings;
+    PropTrie suffixes, prefixes;
+
+    struct Exact {
+        std::string_view name;
+        uint32_t value;
+    };
+    std::vector<Exact> exact;
+
+    // Pool offsets of the pattern and value of every glob, by rule index
+    std::vector<std::pair<uint32_t, uint32_t>> globStrings(unique.size());
+
+    // Exact names and the literal part of suffixes, the tail table is only built when these are
+    // all the rules there are
+    struct Literal {
+        std::string_view literal;
+        PropRuleKind kind;
+        uint32_t value;
+    };
+    std::vector<Literal> literals;
+    bool onlyLiterals = true;
+
+    for (uint32_t i = 0; i < unique.size(); ++i) {
+        auto [pattern, value] = unique[i];
+        PropRuleKind kind;
+
+        if (!classifyPropPattern(pattern, kind)) continue;
+
+        uint32_t valueOffset = strings.add(value);
+
+        switch (kind) {
+            case PROP_RULE_EXACT:
+                exact.push_back({pattern, valueOffset});
+                strings.add(pattern);
+                literals.push_back({pattern, kind, valueOffset});
+                break;
+            case PROP_RULE_SUFFIX:
+                suffixes.nodes[suffixes.insert(pattern.substr(1), true)].value = valueOffset;
+                literals.push_back({pattern.substr(1), kind, valueOffset});
+                strings.add(pattern.substr(1));
+                break;
+            case PROP_RULE_PREFIX:
+                onlyLiterals = false;
+                prefixes.nodes[prefixes.insert(pattern.substr(0, pattern.size() - 1), false)].value =
+                        valueOffset;
+                break;
+            case PROP_RULE_GLOB: {
+                onlyLiterals = false;
+                size_t head = pattern.find_first_of("*?");
+                size_t tail = pattern.find_last_of("*?") + 1;
+
+                if (tail < pattern.size() || head == 0) {
+                    suffixes.nodes[suffixes.insert(pattern.substr(tail), true)].globs.push_back(i);
+                } else {
+                    prefixes.nodes[prefixes.insert(pattern.substr(0, head), false)].globs.push_back(i);
+                }
+
+                globStrings[i] = {strings.add(pattern), valueOffset};
+                break;
+            }
+        }
+    }
+
+    suffixes.compress(true);
+    prefixes.compress(false);
+
+    std::vector<PropTail> tails;
+
+    for (uint32_t i = 0; onlyLiterals && i < literals.size(); ++i) {
+        std::string_view literal = literals[i].literal;
+
+        if (literal.size() < PROP_TAIL_CHARS) {
+            onlyLiterals = false;
+            break;
+        }
+
+        auto tail = readLE<uint64_t>(reinterpret_cast<const uint8_t *>(literal.data()) +
+                                     literal.size() - PROP_TAIL_CHARS);
+        auto same = std::ranges::find(tails, tail, &PropTail::tail);
+
+        if (same != tails.end()) same->rule = PROP_TAIL_SHARED;
+        else tails.push_back({tail, i});
+    }
+
+    uint64_t tailSeed = 0;
+    uint32_t tailBits = 0;
+    bool hasTails = onlyLiterals && findTailSeed(tails, tailSeed, tailBits);
+
+    uint32_t slotCount = 8;
+    while (slotCount < exact.size() * 2) slotCount <<= 1;
+
+    size_t nodeCount = suffixes.nodes.size() + prefixes.nodes.size();
+    size_t tailsOffset = PROP_MATCHER_HEADER_SIZE + size_t(slotCount) * PROP_MATCHER_SLOT_SIZE;
+    size_t nodesOffset = tailsOffset +
+                         (hasTails ? (size_t(1) << tailBits) * PROP_MATCHER_TAIL_SIZE : 0);
+    size_t extraOffset = nodesOffset + nodeCount * PROP_MATCHER_NODE_SIZE;
+
+    // Edges and glob lists go after the nodes, then the strings
+    std::vector<uint8_t> extra;
+
+    auto appendU32 = [&](uint32_t value) {
+        size_t offset = extra.size();
+        extra.resize(offset + 4);
+        writeLE<uint32_t>(extra.data() + offset, value);
+    };
+
+    std::vector<uint8_t> nodes(nodeCount * PROP_MATCHER_NODE_SIZE);
+    uint32_t stringsOffset = 0;
+
+    // Two passes, the first one only sizes extra so the second one knows where strings go
+    for (int pass = 0; pass < 2; ++pass) {
+        extra.clear();
+
+        auto writeTrie = [&](const PropTrie &trie, size_t firstNode) {
+            for (size_t i = 0; i < trie.nodes.size(); ++i) {
+                const PropTrieNode &node = trie.nodes[i];
+                uint8_t *entry = nodes.data() + (firstNode + i) * PROP_MATCHER_NODE_SIZE;
+
+                uint32_t value = node.value == PROP_NO_VALUE ? PROP_NO_VALUE
+                                                             : stringsOffset + node.value;
+                writeLE<uint32_t>(entry, value);
+                writeLE<uint32_t>(entry + 8, node.edges.size());
+                writeLE<uint32_t>(entry + 12, extraOffset + extra.size());
+
+                for (auto &edge: node.edges) extra.push_back(static_cast<uint8_t>(edge.c));
+                extra.resize((extra.size() + 3) & ~size_t(3));
+
+                for (auto &edge: node.edges) {
+                    appendU32(nodesOffset + (firstNode + edge.child) * PROP_MATCHER_NODE_SIZE);
+                    appendU32(stringsOffset + strings.add(edge.label));
+                    appendU32(edge.label.size());
+                }
+
+                if (node.globs.empty()) {
+                    writeLE<uint32_t>(entry + 4, 0);
+                    continue;
+                }
+
+                writeLE<uint32_t>(entry + 4, extraOffset + extra.size());
+                appendU32(node.globs.size());
+
+                for (uint32_t rule: node.globs) {
+                    auto [pattern, value] = globStrings[rule];
+                    appendU32(stringsOffset + pattern);
+                    appendU32(unique[rule].pattern.size());
+                    appendU32(stringsOffset + value);
+                    appendU32(rule);
+                }
+            }
+        };
+
+        writeTrie(suffixes, 0);
+        writeTrie(prefixes, suffixes.nodes.size());
+
+        stringsOffset = extraOffset + extra.size();
+    }
+
+    size_t size = stringsOffset + strings.data.size();
+
+    if (size > PROP_MATCHER_MAX) return {};
+
+    std::vector<uint8_t> out(nodesOffset);
+
+    writeLE<uint32_t>(out.data(), PROP_MATCHER_MAGIC);
+    writeLE<uint16_t>(out.data() + 4, PROP_MATCHER_VERSION);
+    writeLE<uint32_t>(out.data() + 8, size);
+    writeLE<uint32_t>(out.data() + 12, slotCount);
+    writeLE<uint32_t>(out.data() + 16, nodesOffset);
+    writeLE<uint32_t>(out.data() + 20, nodeCount);
+    writeLE<uint32_t>(out.data() + 24, nodesOffset);
+    writeLE<uint32_t>(out.data() + 28, nodesOffset + suffixes.nodes.size() * PROP_MATCHER_NODE_SIZE);
+
+    if (hasTails) {
+        writeLE<uint32_t>(out.data() + 32, tailsOffset);
+        writeLE<uint32_t>(out.data() + 36, tailBits);
+        writeLE<uint64_t>(out.data() + 40, tailSeed);
+    } else {
+        tails.clear();
+    }
+
+    for (auto &[tail, rule]: tails) {
+        uint8_t *slot = out.data() + tailsOffset +
+                        propTailSlot(tail, tailSeed, tailBits) * PROP_MATCHER_TAIL_SIZE;
+        writeLE<uint64_t>(slot, tail);
+
+        if (rule == PROP_TAIL_SHARED) {
+            writeLE<uint32_t>(slot + 20, PROP_TAIL_SHARED);
+            continue;
+        }
+
+        auto &[literal, kind, value] = literals[rule];
+        writeLE<uint32_t>(slot + 8, stringsOffset + strings.add(literal));
+        writeLE<uint32_t>(slot + 12, literal.size());
+        writeLE<uint32_t>(slot + 16, stringsOffset + value);
+        writeLE<uint32_t>(slot + 20, kind);
+    }
+
+    uint32_t mask = slotCount - 1;
+
+    for (auto &[name, value]: exact) {
+        uint32_t hash = nameHash(name);
+        uint32_t i = hash & mask;
+
+        while (readLE<uint32_t>(out.data() + PROP_MATCHER_HEADER_SIZE + i * PROP_MATCHER_SLOT_SIZE + 4))
+            i = (i + 1) & mask;
+
+        uint8_t *slot = out.data() + PROP_MATCHER_HEADER_SIZE + i * PROP_MATCHER_SLOT_SIZE;
+        writeLE<uint32_t>(slot, hash);
+        writeLE<uint32_t>(slot + 4, stringsOffset + strings.add(name));
+        writeLE<uint32_t>(slot + 8, name.size());
+        writeLE<uint32_t>(slot + 12, stringsOffset + value);
+    }
+
+    out.insert(out.end(), nodes.begin(), nodes.end());
+    out.insert(out.end(), extra.begin(), extra.end());
+    out.insert(out.end(), strings.data.begin(), strings.data.end());
+
+    return out;
+}
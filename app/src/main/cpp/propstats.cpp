@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "propstats.hpp"
+
+static uint32_t nameHash(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name) {
+        hash ^= static_cast<uint8_t>(*name);
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+void recordPropRead(PropStats &stats, const char *name, bool overridden, uint64_t ns) {
+    uint32_t hash = nameHash(name);
+
+    for (size_t probe = 0; probe < PROP_STATS_PROBES; ++probe) {
+        PropStatsSlot &slot = stats.slots[(hash + probe) % PROP_STATS_SLOTS];
+        uint32_t current = slot.hash.load(std::memory_order_relaxed);
+
+        if (current == 0 && slot.hash.compare_exchange_strong(current, hash,
+                                                               std::memory_order_relaxed)) {
+            strncpy(slot.name, name, sizeof(slot.name) - 1);
+            slot.ready.store(1, std::memory_order_release);
+            current = hash;
+        }
+
+        if (current != hash) continue;
+
+        size_t bucket = std::min<size_t>(std::bit_width(ns >> 6), PROP_STATS_BUCKETS - 1);
+
+        slot.hits.fetch_add(1, std::memory_order_relaxed);
+        if (overridden) slot.overrides.fetch_add(1, std::memory_order_relaxed);
+        slot.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    stats.dropped.fetch_add(1, std::memory_order_relaxed);
+}
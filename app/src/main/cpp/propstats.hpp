@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Property read statistics, a region the companion creates and shares with the hook in every
+// process it sends the stub to. The hook only bumps counters, the companion summarizes them
+// in a file, so collecting never goes through logd. Everything is 32-bit so 32 and 64-bit
+// processes agree on the layout.
+#define PROP_STATS_MAGIC 0x53524950 // PIRS
+#define PROP_STATS_VERSION 1
+#define PROP_STATS_SLOTS 256
+// Slots tried before a read counts as dropped
+#define PROP_STATS_PROBES 8
+// Longer names are cut, the hash still tells them apart
+#define PROP_STATS_NAME_SIZE 64
+// Bucket i counts reads below 2^(i + 6) ns, the last one everything slower
+#define PROP_STATS_BUCKETS 16
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Counters are shared by processes");
+
+struct PropStatsSlot {
+    // FNV-1a of the name, 0 while the slot is free
+    std::atomic<uint32_t> hash{0};
+    // Set once name is written
+    std::atomic<uint32_t> ready{0};
+    std::atomic<uint32_t> hits{0};
+    std::atomic<uint32_t> overrides{0};
+    std::atomic<uint32_t> latency[PROP_STATS_BUCKETS]{};
+    char name[PROP_STATS_NAME_SIZE]{};
+};
+
+struct PropStats {
+    uint32_t magic = PROP_STATS_MAGIC;
+    uint32_t version = PROP_STATS_VERSION;
+    // Reads of properties that found no free slot
+    std::atomic<uint32_t> dropped{0};
+    uint32_t reserved = 0;
+    PropStatsSlot slots[PROP_STATS_SLOTS];
+};
+
+// Checks a region received from the companion before the hook writes to it
+bool isPropStats(const void *region, size_t size);
+
+// ns covers the real read and the callbacks it ran
+void recordPropRead(PropStats &stats, const char *name, bool overridden, uint64_t ns);
+
+// One line per property, most read first. Any process the region went to can write to it,
+// so nothing in it is trusted.
+void writePropStats(const PropStats &stats, FILE *file);
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "propstats.hpp"
+
+// Reading the region back, kept apart from recordPropRead() so the hook stub goes without it
+bool isPropStats(const void *region, size_t size) {
+    if (size != sizeof(PropStats)) return false;
+
+    auto *stats = static_cast<const PropStats *>(region);
+    return stats->magic == PROP_STATS_MAGIC && stats->version == PROP_STATS_VERSION;
+}
+
+void writePropStats(const PropStats &stats, FILE *file) {
+    // Hooks keep counting meanwhile, so slots are sorted by a snapshot of their hits
+    std::vector<std::pair<uint32_t, const PropStatsSlot *>> slots;
+    uint64_t reads = 0;
+
+    for (auto &slot: stats.slots) {
+        if (!slot.ready.load(std::memory_order_acquire)) continue;
+
+        uint32_t hits = slot.hits.load(std::memory_order_relaxed);
+        slots.emplace_back(hits, &slot);
+        reads += hits;
+    }
+
+    std::ranges::sort(slots, std::greater{}, &std::pair<uint32_t, const PropStatsSlot *>::first);
+
+    fprintf(file, "%zu properties, %llu reads, %u dropped\n", slots.size(),
+            static_cast<unsigned long long>(reads), stats.dropped.load(std::memory_order_relaxed));
+
+    for (auto [hits, slot]: slots) {
+        fprintf(file, "%.*s | hits %u | overridden %u |",
+                static_cast<int>(strnlen(slot->name, sizeof(slot->name))), slot->name, hits,
+                slot->overrides.load(std::memory_order_relaxed));
+
+        for (size_t i = 0; i < PROP_STATS_BUCKETS; ++i) {
+            uint32_t count = slot->latency[i].load(std::memory_order_relaxed);
+            if (count == 0) continue;
+
+            if (i == PROP_STATS_BUCKETS - 1) {
+                fprintf(file, " >=%lluus:%u", (1ull << (i + 5)) / 1000, count);
+            } else {
+                fprintf(file, " <%lluns:%u", 1ull << (i + 6), count);
+            }
+        }
+
+        fputc('\n', file);
+    }
+}
@@ -0,0 +1,446 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include "log.hpp"
+#include "protocol.hpp"
+#include "symbols.hpp"
+
+int64_t nowNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int64_t deadlineAfterMs(int64_t ms) {
+    return nowNs() + ms * 1000000;
+}
+
+// Waits until fd is ready for events or the deadline expires, a negative deadline waits forever
+static bool waitFd(int fd, short events, int64_t deadline) {
+    pollfd pfd{fd, events, 0};
+
+    while (true) {
+        int timeout = -1;
+
+        if (deadline >= 0) {
+            int64_t remaining = deadline - nowNs();
+            if (remaining <= 0) return false;
+            timeout = static_cast<int>((remaining + 999999) / 1000000);
+        }
+
+        int ret = poll(&pfd, 1, timeout);
+
+        if (ret > 0) return true;
+        if (ret == 0 || errno != EINTR) return false;
+    }
+}
+
+ssize_t xread(int fd, void *buffer, size_t count_to_read, int64_t deadline) {
+    ssize_t total_read = 0;
+    char *current_buf = static_cast<char *>(buffer);
+    size_t remaining_bytes = count_to_read;
+
+    while (remaining_bytes > 0) {
+        if (!waitFd(fd, POLLIN, deadline)) {
+            return -1;
+        }
+
+        ssize_t ret = TEMP_FAILURE_RETRY(read(fd, current_buf, remaining_bytes));
+
+        if (ret < 0) {
+            return -1;
+        }
+
+        if (ret == 0) {
+            break;
+        }
+
+        current_buf += ret;
+        total_read += ret;
+        remaining_bytes -= ret;
+    }
+
+    return total_read;
+}
+
+ssize_t xwrite(int fd, const void *buffer, size_t count_to_write, int64_t deadline) {
+    ssize_t total_written = 0;
+    const char *current_buf = static_cast<const char *>(buffer);
+    size_t remaining_bytes = count_to_write;
+
+    while (remaining_bytes > 0) {
+        if (!waitFd(fd, POLLOUT, deadline)) {
+            return -1;
+        }
+
+        ssize_t ret = TEMP_FAILURE_RETRY(write(fd, current_buf, remaining_bytes));
+
+        if (ret < 0) {
+            return -1;
+        }
+
+        if (ret == 0) {
+            break;
+        }
+
+        current_buf += ret;
+        total_written += ret;
+        remaining_bytes -= ret;
+    }
+
+    return total_written;
+}
+
+#define PROTOCOL_MAX_FIELDS 8
+
+struct Field {
+    uint16_t type;
+    const void *data;
+    size_t size;
+};
+
+static uint32_t checksum(const uint8_t *data, size_t size, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Every message has a fixed set of fields, so their count is checked when it's compiled
+template<size_t N>
+static bool sendFields(int sockfd, std::span<const int> fds, const Field (&fields)[N],
+                       int64_t deadline) {
+    static_assert(N <= PROTOCOL_MAX_FIELDS, "Too many fields for one message");
+
+    uint8_t header[PROTOCOL_HEADER_SIZE]{};
+    uint8_t fieldHeaders[N][PROTOCOL_FIELD_HEADER_SIZE]{};
+    iovec iov[1 + N * 2];
+    size_t iovCount = 0;
+
+    size_t payloadSize = 0;
+    uint32_t hash = checksum(nullptr, 0);
+
+    iov[iovCount++] = {header, sizeof(header)};
+
+    for (size_t i = 0; i < N; ++i) {
+        auto &field = fields[i];
+
+        writeLE<uint16_t>(fieldHeaders[i], field.type);
+        writeLE<uint32_t>(fieldHeaders[i] + 2, field.size);
+
+        hash = checksum(fieldHeaders[i], PROTOCOL_FIELD_HEADER_SIZE, hash);
+        hash = checksum(static_cast<const uint8_t *>(field.data), field.size, hash);
+
+        iov[iovCount++] = {fieldHeaders[i], PROTOCOL_FIELD_HEADER_SIZE};
+        iov[iovCount++] = {const_cast<void *>(field.data), field.size};
+
+        payloadSize += PROTOCOL_FIELD_HEADER_SIZE + field.size;
+    }
+
+    if (payloadSize > PROTOCOL_MAX_PAYLOAD) return false;
+
+    writeLE<uint32_t>(header, PROTOCOL_MAGIC);
+    header[4] = PROTOCOL_VERSION;
+    writeLE<uint16_t>(header + 6, N);
+    writeLE<uint32_t>(header + 8, payloadSize);
+    writeLE<uint32_t>(header + 12, hash);
+
+    if (fds.size() > PROTOCOL_MAX_FDS) return false;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * PROTOCOL_MAX_FDS)]{};
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovCount;
+
+    if (!fds.empty()) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    if (!waitFd(sockfd, POLLOUT, deadline)) return false;
+
+    ssize_t sent = TEMP_FAILURE_RETRY(sendmsg(sockfd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT));
+
+    if (sent < 0) return false;
+
+    // Finish a short write with plain writes of whatever is left
+    for (size_t i = 0; i < iovCount; ++i) {
+        auto &vec = iov[i];
+
+        if (static_cast<size_t>(sent) >= vec.iov_len) {
+            sent -= static_cast<ssize_t>(vec.iov_len);
+            continue;
+        }
+
+        size_t remaining = vec.iov_len - sent;
+        if (xwrite(sockfd, static_cast<const uint8_t *>(vec.iov_base) + sent, remaining,
+                   deadline) != static_cast<ssize_t>(remaining))
+            return false;
+        sent = 0;
+    }
+
+    return true;
+}
+
+// resize(size) returns the receive buffer at that size with its contents kept, nullptr if it
+// can't grow. Received descriptors fill fds in order, the rest of fds is set to -1 and extra
+// ones are closed.
+template<typename R, typename F>
+static bool recvFields(int sockfd, R &&resize, std::span<int> fds, int64_t deadline,
+                       F &&onField) {
+    for (int &fd: fds) fd = -1;
+
+    // Big enough for any sane pif.json, so the whole message arrives in one recvmsg
+    size_t initialSize = 16 * 1024;
+    uint8_t *buffer = resize(initialSize);
+
+    if (!buffer) return false;
+
+    iovec iov{buffer, initialSize};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * PROTOCOL_MAX_FDS)]{};
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (!waitFd(sockfd, POLLIN, deadline)) return false;
+
+    ssize_t received = TEMP_FAILURE_RETRY(recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT));
+
+    if (received <= 0) return false;
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+        for (size_t i = 0; i < count; ++i) {
+            int receivedFd = -1;
+            memcpy(&receivedFd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (i < fds.size()) fds[i] = receivedFd;
+            else close(receivedFd);
+        }
+    }
+
+    if (received < PROTOCOL_HEADER_SIZE) {
+        size_t remaining = PROTOCOL_HEADER_SIZE - received;
+        if (xread(sockfd, buffer + received, remaining, deadline) !=
+            static_cast<ssize_t>(remaining))
+            return false;
+        received = PROTOCOL_HEADER_SIZE;
+    }
+
+    const uint8_t *header = buffer;
+
+    if (readLE<uint32_t>(header) != PROTOCOL_MAGIC) {
+        LOGE("Companion message has a bad magic!");
+        return false;
+    }
+
+    if (header[4] != PROTOCOL_VERSION) {
+        LOGE("Companion protocol version mismatch: %d != %d", header[4], PROTOCOL_VERSION);
+        return false;
+    }
+
+    uint16_t fieldCount = readLE<uint16_t>(header + 6);
+    size_t payloadSize = readLE<uint32_t>(header + 8);
+    uint32_t hash = readLE<uint32_t>(header + 12);
+
+    if (payloadSize > PROTOCOL_MAX_PAYLOAD) return false;
+
+    size_t total = PROTOCOL_HEADER_SIZE + payloadSize;
+
+    // Also gives back what the first recvmsg didn't need
+    buffer = resize(total);
+
+    if (!buffer) return false;
+
+    if (static_cast<size_t>(received) < total) {
+        size_t remaining = total - received;
+        if (xread(sockfd, buffer + received, remaining, deadline) !=
+            static_cast<ssize_t>(remaining))
+            return false;
+    }
+
+    const uint8_t *ptr = buffer + PROTOCOL_HEADER_SIZE;
+    const uint8_t *end = ptr + payloadSize;
+
+    if (checksum(ptr, payloadSize) != hash) {
+        LOGE("Companion message checksum mismatch!");
+        return false;
+    }
+
+    for (uint16_t i = 0; i < fieldCount; ++i) {
+        if (end - ptr < PROTOCOL_FIELD_HEADER_SIZE) return false;
+
+        uint16_t type = readLE<uint16_t>(ptr);
+        size_t size = readLE<uint32_t>(ptr + 2);
+        ptr += PROTOCOL_FIELD_HEADER_SIZE;
+
+        if (static_cast<size_t>(end - ptr) < size) return false;
+
+        onField(type, ptr, size);
+
+        ptr += size;
+    }
+
+    return true;
+}
+
+bool sendMessage(int sockfd, const CompanionFds &fds, const CompanionMessage &message,
+                 int64_t deadline) {
+    uint8_t dexSize[8]{};
+    uint8_t hookSize[8]{};
+    uint8_t statsSize[8]{};
+    uint8_t reportsSize[8]{};
+    uint8_t libcSymbol[8 + LIBC_BUILD_ID_MAX]{};
+    uint8_t flags[4]{};
+
+    // A size is only sent along with its descriptor, the receiver matches them up by order
+    int sentFds[PROTOCOL_MAX_FDS];
+    size_t fdCount = 0;
+
+    if (fds.dex >= 0 && message.dexSize > 0) {
+        writeLE<uint64_t>(dexSize, message.dexSize);
+        sentFds[fdCount++] = fds.dex;
+    }
+
+    if (fds.hook >= 0 && message.hookSize > 0) {
+        writeLE<uint64_t>(hookSize, message.hookSize);
+        sentFds[fdCount++] = fds.hook;
+    }
+
+    if (fds.stats >= 0 && message.statsSize > 0) {
+        writeLE<uint64_t>(statsSize, message.statsSize);
+        sentFds[fdCount++] = fds.stats;
+    }
+
+    if (fds.reports >= 0 && message.reportsSize > 0) {
+        writeLE<uint64_t>(reportsSize, message.reportsSize);
+        sentFds[fdCount++] = fds.reports;
+    }
+
+    size_t libcSymbolSize = 0;
+
+    if (!message.libcBuildId.empty() && message.libcBuildId.size() <= LIBC_BUILD_ID_MAX) {
+        writeLE<uint64_t>(libcSymbol, message.libcOffset);
+        memcpy(libcSymbol + 8, message.libcBuildId.data(), message.libcBuildId.size());
+        libcSymbolSize = 8 + message.libcBuildId.size();
+    }
+
+    writeLE<uint32_t>(flags, message.flags);
+
+    const Field fields[] = {
+            {FIELD_DEX_SIZE,     dexSize,               sizeof(dexSize)},
+            {FIELD_HOOK_SIZE,    hookSize,              sizeof(hookSize)},
+            {FIELD_STATS_SIZE,   statsSize,             sizeof(statsSize)},
+            {FIELD_REPORTS_SIZE, reportsSize,           sizeof(reportsSize)},
+            {FIELD_LIBC_SYMBOL,  libcSymbol,            libcSymbolSize},
+            {FIELD_CONFIG,       message.config.data(), message.config.size()},
+            {FIELD_FLAGS,        flags,                 sizeof(flags)},
+            {FIELD_STATUS,       &message.status,       1},
+    };
+
+    return sendFields(sockfd, {sentFds, fdCount}, fields, deadline);
+}
+
+bool recvMessage(int sockfd, Arena &arena, CompanionMessage &message, CompanionFds &fds,
+                 int64_t deadline) {
+    int receivedFds[PROTOCOL_MAX_FDS];
+    void *buffer = nullptr;
+
+    auto resize = [&](size_t size) {
+        buffer = buffer ? arena.resize(buffer, size) : arena.allocate(size);
+        return static_cast<uint8_t *>(buffer);
+    };
+
+    bool received = recvFields(sockfd, resize, receivedFds, deadline,
+                               [&](uint16_t type, const uint8_t *data, size_t size) {
+                                   switch (type) {
+                                       case FIELD_DEX_SIZE:
+                                           if (size == sizeof(uint64_t))
+                                               message.dexSize = readLE<uint64_t>(data);
+                                           break;
+                                       case FIELD_HOOK_SIZE:
+                                           if (size == sizeof(uint64_t))
+                                               message.hookSize = readLE<uint64_t>(data);
+                                           break;
+                                       case FIELD_STATS_SIZE:
+                                           if (size == sizeof(uint64_t))
+                                               message.statsSize = readLE<uint64_t>(data);
+                                           break;
+                                       case FIELD_REPORTS_SIZE:
+                                           if (size == sizeof(uint64_t))
+                                               message.reportsSize = readLE<uint64_t>(data);
+                                           break;
+                                       case FIELD_LIBC_SYMBOL:
+                                           if (size > 8 && size <= 8 + LIBC_BUILD_ID_MAX) {
+                                               message.libcOffset = readLE<uint64_t>(data);
+                                               message.libcBuildId = {data + 8, size - 8};
+                                           }
+                                           break;
+                                       case FIELD_CONFIG:
+                                           message.config = {data, size};
+                                           break;
+                                       case FIELD_FLAGS:
+                                           if (size == sizeof(uint32_t))
+                                               message.flags = readLE<uint32_t>(data);
+                                           break;
+                                       case FIELD_STATUS:
+                                           if (size == 1) message.status = *data;
+                                           break;
+                                       default:
+                                           break;
+                                   }
+                               });
+
+    size_t next = 0;
+    fds.dex = message.dexSize > 0 ? receivedFds[next++] : -1;
+    fds.hook = message.hookSize > 0 ? receivedFds[next++] : -1;
+    fds.stats = message.statsSize > 0 ? receivedFds[next++] : -1;
+    fds.reports = message.reportsSize > 0 ? receivedFds[next++] : -1;
+
+    for (; next < PROTOCOL_MAX_FDS; ++next) {
+        if (receivedFds[next] >= 0) close(receivedFds[next]);
+    }
+
+    return received;
+}
+
+bool sendRequest(int sockfd, const ModuleRequest &request, int64_t deadline) {
+    const Field fields[] = {
+            {FIELD_REQUEST, &request.request, 1},
+    };
+
+    return sendFields(sockfd, {}, fields, deadline);
+}
+
+bool recvRequest(int sockfd, std::vector<uint8_t> &buffer, ModuleRequest &request,
+                 int64_t deadline) {
+    auto resize = [&](size_t size) {
+        buffer.resize(size);
+        return buffer.data();
+    };
+
+    return recvFields(sockfd, resize, {}, deadline,
+                      [&](uint16_t type, const uint8_t *data, size_t size) {
+                          switch (type) {
+                              case FIELD_REQUEST:
+                                  if (size == 1) request.request = *data;
+                                  break;
+                              default:
+                                  break;
+                          }
+                      });
+}
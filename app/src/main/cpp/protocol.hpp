@@ -0,0 +1,96 @@
+#pragma once
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "arena.hpp"
+#include "bytes.hpp"
+
+int64_t nowNs();
+
+int64_t deadlineAfterMs(int64_t ms);
+
+// Blocking loops over read/write, a non-negative deadline (nowNs() based) bounds the whole call
+ssize_t xread(int fd, void *buffer, size_t count_to_read, int64_t deadline = -1);
+
+ssize_t xwrite(int fd, const void *buffer, size_t count_to_write, int64_t deadline = -1);
+
+// Companion <-> module wire format, all integers little-endian:
+//   header: magic u32, version u8, reserved u8, field count u16, payload size u32, checksum u32
+//   field:  type u16, size u32, value[size]
+// Fields can be appended without bumping the version, receivers skip unknown types.
+// The module speaks first with a request, REQUEST_CONFIG is answered with a CompanionMessage.
+// REQUEST_WARM_UP has no answer, system_server's fork sends it at boot so the companion has
+// everything loaded before the first app asks.
+// Launch stats come back through the LaunchReports region, as the module can't connect again
+// after specialization.
+// File descriptors travel as SCM_RIGHTS ancillary data of the config message, the dex first,
+// then the hook stub, the property stats and the launch reports, each only when its size field
+// is non-zero.
+#define PROTOCOL_MAGIC 0x46495050 // "PPIF"
+#define PROTOCOL_VERSION 2
+#define PROTOCOL_HEADER_SIZE 16
+#define PROTOCOL_FIELD_HEADER_SIZE 6
+#define PROTOCOL_MAX_PAYLOAD (1 << 20)
+#define PROTOCOL_MAX_FDS 4
+
+enum FieldType : uint16_t {
+    FIELD_DEX_SIZE = 1,
+    FIELD_CONFIG = 6,
+    FIELD_FLAGS = 7,
+    FIELD_REQUEST = 8,
+    FIELD_STATUS = 10,
+    FIELD_HOOK_SIZE = 11,
+    FIELD_STATS_SIZE = 13,
+    // offset u64 then the libc build ID
+    FIELD_LIBC_SYMBOL = 14,
+    FIELD_REPORTS_SIZE = 15,
+};
+
+enum Request : uint8_t {
+    REQUEST_CONFIG = 1,
+    REQUEST_WARM_UP = 2,
+};
+
+struct ModuleRequest {
+    uint8_t request = 0;
+};
+
+struct CompanionMessage {
+    uint64_t dexSize = 0;
+    uint64_t hookSize = 0;
+    // Size of the shared PropStats region
+    uint64_t statsSize = 0;
+    // Size of the shared LaunchReports region
+    uint64_t reportsSize = 0;
+    // Where the hooked symbol is in libc, only sent when the companion could resolve it
+    uint64_t libcOffset = 0;
+    std::span<const uint8_t> libcBuildId;
+    std::span<const uint8_t> config;
+    // Effective ConfigFlag bits, after TrickyStore and test-keys detection
+    uint32_t flags = 0;
+    // ConfigStatus of the config, or of why there's none
+    uint8_t status = 0;
+};
+
+// -1 when not sent
+struct CompanionFds {
+    int dex = -1;
+    int hook = -1;
+    int stats = -1;
+    int reports = -1;
+};
+
+bool sendMessage(int sockfd, const CompanionFds &fds, const CompanionMessage &message,
+                 int64_t deadline);
+
+// The message, config included, is received into arena and stays valid until it's released
+bool recvMessage(int sockfd, Arena &arena, CompanionMessage &message, CompanionFds &fds,
+                 int64_t deadline);
+
+bool sendRequest(int sockfd, const ModuleRequest &request, int64_t deadline);
+
+bool recvRequest(int sockfd, std::vector<uint8_t> &buffer, ModuleRequest &request,
+                 int64_t deadline);
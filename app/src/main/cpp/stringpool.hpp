@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Adds each distinct string to the pool once, NUL-terminated. Pools hold a few dozen strings
+// at most, so a linear search beats hashing.
+class StringPool {
+public:
+    uint32_t add(std::string_view str) {
+        for (auto &[interned, offset]: strings) {
+            if (interned == str) return offset;
+        }
+
+        auto offset = static_cast<uint32_t>(data.size());
+        data.insert(data.end(), str.begin(), str.end());
+        data.push_back(0);
+        strings.emplace_back(str, offset);
+        return offset;
+    }
+
+    std::vector<uint8_t> data;
+
+private:
+    std::vector<std::pair<std::string_view, uint32_t>> strings;
+};
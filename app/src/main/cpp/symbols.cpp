@@ -0,0 +1,120 @@
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include "symbols.hpp"
+
+struct LibcImage {
+    // Only valid during dl_iterate_phdr
+    const dl_phdr_info *info;
+    std::span<const uint8_t> buildId;
+};
+
+static std::span<const uint8_t> findBuildId(const dl_phdr_info *info) {
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const auto &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE) continue;
+
+        auto *note = reinterpret_cast<const uint8_t *>(info->dlpi_addr + phdr.p_vaddr);
+        auto *end = note + phdr.p_memsz;
+
+        while (end - note >= static_cast<ptrdiff_t>(sizeof(ElfW(Nhdr)))) {
+            auto *header = reinterpret_cast<const ElfW(Nhdr) *>(note);
+            size_t nameSize = (header->n_namesz + 3) & ~size_t(3);
+            size_t descSize = (header->n_descsz + 3) & ~size_t(3);
+            const uint8_t *name = note + sizeof(ElfW(Nhdr));
+            const uint8_t *desc = name + nameSize;
+
+            if (nameSize > static_cast<size_t>(end - name) ||
+                descSize > static_cast<size_t>(end - desc))
+                break;
+
+            if (header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0) {
+                return {desc, header->n_descsz};
+            }
+
+            note = desc + descSize;
+        }
+    }
+
+    return {};
+}
+
+// Runs onLibc on the libc loaded in this process, without touching any symbol table
+template<typename F>
+static bool withLibc(F &&onLibc) {
+    struct Search {
+        std::remove_reference_t<F> *onLibc;
+        bool result = false;
+    } search{&onLibc};
+
+    dl_iterate_phdr([](dl_phdr_info *info, size_t, void *data) -> int {
+        std::string_view name = info->dlpi_name ? info->dlpi_name : "";
+        if (!name.ends_with("/" LIBC_NAME)) return 0;
+
+        auto *search = static_cast<Search *>(data);
+        search->result = (*search->onLibc)(LibcImage{info, findBuildId(info)});
+        return 1;
+    }, &search);
+
+    return search.result;
+}
+
+void *findLibcSymbol(const char *symbol) {
+    void *handle = dlopen(LIBC_NAME, RTLD_NOW | RTLD_NOLOAD);
+    if (!handle) return nullptr;
+
+    void *address = dlsym(handle, symbol);
+    dlclose(handle);
+
+    return address;
+}
+
+bool resolveLibcSymbol(const char *symbol, LibcSymbol &out) {
+    void *address = findLibcSymbol(symbol);
+    if (!address) return false;
+
+    return withLibc([&](const LibcImage &libc) {
+        auto base = static_cast<uintptr_t>(libc.info->dlpi_addr);
+        auto target = reinterpret_cast<uintptr_t>(address);
+
+        if (libc.buildId.empty() || target < base) return false;
+
+        out.buildIdSize = std::min<size_t>(libc.buildId.size(), LIBC_BUILD_ID_MAX);
+        memcpy(out.buildId, libc.buildId.data(), out.buildIdSize);
+        out.offset = target - base;
+        return true;
+    });
+}
+
+void *libcSymbolAddress(std::span<const uint8_t> buildId, uint64_t offset) {
+    if (buildId.empty()) return nullptr;
+
+    void *address = nullptr;
+
+    withLibc([&](const LibcImage &libc) {
+        auto ours = libc.buildId.first(std::min<size_t>(libc.buildId.size(), LIBC_BUILD_ID_MAX));
+
+        if (ours.size() != buildId.size() || memcmp(ours.data(), buildId.data(), ours.size()) != 0)
+            return false;
+
+        // Same file, but the offset came over a socket, so it has to land in libc's code
+        for (int i = 0; i < libc.info->dlpi_phnum; ++i) {
+            const auto &phdr = libc.info->dlpi_phdr[i];
+
+            if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) && offset >= phdr.p_vaddr &&
+                offset - phdr.p_vaddr < phdr.p_memsz) {
+                address = reinterpret_cast<void *>(libc.info->dlpi_addr + offset);
+                return true;
+            }
+        }
+
+        return false;
+    });
+
+    return address;
+}
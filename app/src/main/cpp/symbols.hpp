@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#ifdef __ANDROID__
+#define LIBC_NAME "libc.so"
+#else
+#define LIBC_NAME "libc.so.6"
+#endif
+
+// GNU build IDs are SHA-1 sized, anything longer is cut
+#define LIBC_BUILD_ID_MAX 20
+
+// Where a libc symbol sits relative to where libc is loaded, valid for the libc with that build
+// ID. The companion resolves it once and processes with the same libc only add their base.
+struct LibcSymbol {
+    uint8_t buildId[LIBC_BUILD_ID_MAX]{};
+    uint8_t buildIdSize = 0;
+    uint64_t offset = 0;
+};
+
+// Looks symbol up in the libc already loaded, never in any other image. nullptr when it's not
+// there.
+void *findLibcSymbol(const char *symbol);
+
+// Resolves symbol like findLibcSymbol() and records it relative to libc, false when it's not
+// there or libc has no build ID
+bool resolveLibcSymbol(const char *symbol, LibcSymbol &out);
+
+// The address buildId and offset point to in this process, nullptr when the libc loaded here
+// has another build ID or offset is outside its code
+void *libcSymbolAddress(std::span<const uint8_t> buildId, uint64_t offset);
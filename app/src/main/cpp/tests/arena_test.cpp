@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "arena.hpp"
+
+TEST(Arena, AllocatesAligned) {
+    Arena arena(4096);
+
+    void *a = arena.allocate(3, 1);
+    void *b = arena.allocate(8, 8);
+
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    EXPECT_GE(static_cast<uint8_t *>(b), static_cast<uint8_t *>(a) + 3);
+}
+
+TEST(Arena, RefusesMoreThanItsCapacity) {
+    Arena arena(4096);
+
+    EXPECT_EQ(arena.allocate(4097), nullptr);
+    ASSERT_NE(arena.allocate(4000), nullptr);
+    EXPECT_EQ(arena.allocate(200), nullptr);
+}
+
+TEST(Arena, ResizesOnlyTheLatestAllocation) {
+    Arena arena(4096);
+
+    auto *a = static_cast<char *>(arena.allocate(16));
+    auto *b = static_cast<char *>(arena.allocate(16));
+    memcpy(b, "kept", 5);
+
+    EXPECT_EQ(arena.resize(a, 32), nullptr);
+    ASSERT_EQ(arena.resize(b, 1024), b);
+    EXPECT_STREQ(b, "kept");
+    EXPECT_EQ(arena.resize(b, 8192), nullptr);
+}
+
+TEST(Arena, PeakSurvivesRelease) {
+    Arena arena(1 << 20);
+
+    ASSERT_NE(arena.allocate(1000), nullptr);
+    arena.release();
+    ASSERT_NE(arena.allocate(10), nullptr);
+
+    EXPECT_GE(arena.peak(), 1000u);
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include "config.hpp"
+#include "props.hpp"
+
+static std::vector<uint8_t> compile(std::string json, ConfigDiagnostics &diagnostics) {
+    return compileConfig(std::span(json.data(), json.size()), diagnostics);
+}
+
+static std::map<std::string, std::string> fieldsOf(const ConfigView &config) {
+    std::map<std::string, std::string> fields;
+    forEachConfigField(config, [&](const BuildField &field, const char *value) {
+        fields[field.name] = value;
+    });
+    return fields;
+}
+
+// The value the config's property matcher reports for name
+static std::string propOf(const ConfigView &config, std::string_view name) {
+    int32_t offset = findPropValue(config.props, name);
+    return offset < 0 ? "<none>" : propValue(config.props, offset);
+}
+
+TEST(Config, CompilesModulePifJson) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({
+      "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+      "MANUFACTURER": "Google",
+      "MODEL": "Pixel 6",
+      "SECURITY_PATCH": "2025-04-05"
+    })", diagnostics);
+
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_OK);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+
+    EXPECT_EQ(config.status, CONFIG_STATUS_OK);
+    EXPECT_EQ(config.flags, CONFIG_SPOOF_PROPS | CONFIG_SPOOF_PROVIDER);
+    EXPECT_EQ(propOf(config, "ro.product.first_api_level"), "21");
+    EXPECT_EQ(propOf(config, "ro.build.version.security_patch"), "2025-04-05");
+    EXPECT_EQ(propOf(config, "ro.system.build.id"), "BP22.250325.012");
+
+    auto fields = fieldsOf(config);
+    EXPECT_EQ(fields["MODEL"], "Pixel 6");
+    EXPECT_EQ(fields["MANUFACTURER"], "Google");
+    EXPECT_EQ(fields["SECURITY_PATCH"], "2025-04-05");
+    // FINGERPRINT is split into the Build fields it's made of
+    EXPECT_EQ(fields["BRAND"], "google");
+    EXPECT_EQ(fields["PRODUCT"], "oriole_beta");
+    EXPECT_EQ(fields["DEVICE"], "oriole");
+    EXPECT_EQ(fields["RELEASE"], "16");
+    EXPECT_EQ(fields["ID"], "BP22.250325.012");
+    EXPECT_EQ(fields["INCREMENTAL"], "13467521");
+    EXPECT_EQ(fields["TYPE"], "user");
+    EXPECT_EQ(fields["TAGS"], "release-keys");
+
+    EXPECT_NE(std::string(config.javaJson).find("\"MODEL\""), std::string::npos);
+}
+
+TEST(Config, FlagsFollowTheJson) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"MODEL": "x", "spoofProvider": false, "spoofSignature": true,
+                              "DEBUG": true, "DEVICE_INITIAL_SDK_INT": 32})", diagnostics);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+    EXPECT_EQ(config.flags, CONFIG_SPOOF_PROPS | CONFIG_SPOOF_SIGNATURE | CONFIG_DEBUG);
+    EXPECT_EQ(propOf(config, "ro.product.first_api_level"), "32");
+    // Flags aren't Build fields
+    EXPECT_EQ(fieldsOf(config).count("DEBUG"), 0u);
+}
+
+TEST(Config, WarnsAboutUnknownKeys) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"MODEL": "x", "NOT_A_FIELD": "y"})", diagnostics);
+
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_WARNINGS);
+    ASSERT_FALSE(diagnostics.messages.empty());
+    for (const auto &message: diagnostics.messages) EXPECT_EQ(message[0], 'W') << message;
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+    EXPECT_EQ(fieldsOf(config).count("NOT_A_FIELD"), 0u);
+}
+
+TEST(Config, FieldsKnowTheirClass) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"MODEL": "x", "SECURITY_PATCH": "2025-04-05"})", diagnostics);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+
+    forEachConfigField(config, [&](const BuildField &field, const char *) {
+        bool version = std::string_view(field.name) == "SECURITY_PATCH";
+        EXPECT_EQ(field.owner, version ? BUILD_CLASS_VERSION : BUILD_CLASS_BUILD) << field.name;
+    });
+}
+
+// Nothing but Build fields reaches EntryPoint, every key left out gets its own warning
+TEST(Config, WarnsAboutEveryDroppedKey) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({
+      "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+      "MODEL": "Pixel 6",
+      "NOT_A_FIELD": "y",
+      "OTHER_KEY": "z",
+      "SKU": "",
+      "HARDWARE": 1,
+      "BRAND": "samsung"
+    })", diagnostics);
+
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_WARNINGS);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+    std::string javaJson = config.javaJson;
+
+    for (const char *key: {"NOT_A_FIELD", "OTHER_KEY", "SKU", "HARDWARE", "samsung"}) {
+        int warnings = 0;
+        for (const auto &message: diagnostics.messages) {
+            if (message[0] == 'W' && message.find(key) != std::string::npos) ++warnings;
+        }
+        EXPECT_EQ(warnings, 1) << key;
+        EXPECT_EQ(javaJson.find(key), std::string::npos) << key;
+    }
+
+    EXPECT_EQ(fieldsOf(config)["BRAND"], "google");
+    EXPECT_NE(javaJson.find("\"MODEL\""), std::string::npos);
+}
+
+TEST(Config, LeavesOutABadFingerprint) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"FINGERPRINT": "google/oriole", "MODEL": "x"})", diagnostics);
+
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_ERRORS);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+    EXPECT_EQ(fieldsOf(config).count("FINGERPRINT"), 0u);
+    EXPECT_EQ(fieldsOf(config)["MODEL"], "x");
+}
+
+TEST(Config, LeavesOutABadSecurityPatch) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"SECURITY_PATCH": "2025-13-05", "MODEL": "x",
+                              "DEVICE_INITIAL_SDK_INT": "thirty"})", diagnostics);
+
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_ERRORS);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+    EXPECT_EQ(config.status, CONFIG_STATUS_ERRORS);
+    EXPECT_EQ(fieldsOf(config).count("SECURITY_PATCH"), 0u);
+    // Falls back to the default
+    EXPECT_EQ(propOf(config, "ro.product.first_api_level"), "21");
+}
+
+TEST(Config, InvalidJsonHasNoRecord) {
+    ConfigDiagnostics diagnostics;
+
+    EXPECT_TRUE(compile("{\"MODEL\": ", diagnostics).empty());
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_INVALID);
+}
+
+TEST(Config, RejectsEveryTruncation) {
+    ConfigDiagnostics diagnostics;
+    auto record = compile(R"({"MODEL": "Pixel 6", "PROPS": {"ro.boot.flash.locked": "1"}})",
+                          diagnostics);
+    ASSERT_FALSE(record.empty());
+
+    for (size_t size = 0; size < record.size(); ++size) {
+        ConfigView config;
+        EXPECT_FALSE(parseConfig(std::span(record).first(size), config)) << size;
+    }
+}
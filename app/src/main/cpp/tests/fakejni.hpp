@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+// Just enough of JNIEnv for jstrings.hpp, strings are UTF-16 like in ART
+struct FakeString {
+    std::u16string chars;
+};
+
+struct FakeEnv {
+    int GetStringLength(FakeString *str) {
+        return static_cast<int>(str->chars.size());
+    }
+
+    // Modified UTF-8, NUL is two bytes and surrogates are encoded one by one
+    void GetStringUTFRegion(FakeString *str, int start, int len, char *buffer) {
+        std::string utf = encode(str->chars.substr(start, len));
+        memcpy(buffer, utf.c_str(), utf.size() + 1);
+    }
+
+    // ART hands out a fresh copy
+    const char *GetStringUTFChars(FakeString *str, bool *isCopy) {
+        std::string utf = encode(str->chars);
+        auto *copy = new char[utf.size() + 1];
+        memcpy(copy, utf.c_str(), utf.size() + 1);
+        if (isCopy) *isCopy = true;
+        return copy;
+    }
+
+    void ReleaseStringUTFChars(FakeString *, const char *chars) {
+        delete[] chars;
+    }
+
+    static std::string encode(std::u16string_view chars) {
+        std::string utf;
+        for (char16_t c: chars) {
+            if (c != 0 && c < 0x80) {
+                utf += static_cast<char>(c);
+            } else if (c < 0x800) {
+                utf += static_cast<char>(0xC0 | c >> 6);
+                utf += static_cast<char>(0x80 | (c & 0x3F));
+            } else {
+                utf += static_cast<char>(0xE0 | c >> 12);
+                utf += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+                utf += static_cast<char>(0x80 | (c & 0x3F));
+            }
+        }
+        return utf;
+    }
+};
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include "fingerprint.hpp"
+
+static const std::string VALID =
+        "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys";
+
+static const std::array<std::string, FINGERPRINT_PART_COUNT> PARTS = {
+        "google", "oriole_beta", "oriole", "16", "BP22.250325.012", "13467521", "user",
+        "release-keys",
+};
+
+static constexpr char SEPARATORS[] = "//://:/";
+
+// Appends in place, operator+ into a temporary trips -Wrestrict on GCC 12
+static void appendPart(std::string &fingerprint, char separator, const std::string &part) {
+    fingerprint.push_back(separator);
+    fingerprint.append(part);
+}
+
+static std::string join(const std::array<std::string, FINGERPRINT_PART_COUNT> &parts) {
+    std::string fingerprint = parts[0];
+    for (size_t i = 1; i < parts.size(); ++i) appendPart(fingerprint, SEPARATORS[i - 1], parts[i]);
+    return fingerprint;
+}
+
+// A fingerprint that fails with error in part, nullopt when the splitter can't report that
+static std::optional<std::string> breakFingerprint(FingerprintError error, FingerprintPart part) {
+    auto parts = PARTS;
+
+    switch (error) {
+        case FINGERPRINT_OK:
+            return std::nullopt;
+        case FINGERPRINT_EMPTY_PART:
+            parts[part].clear();
+            return join(parts);
+        case FINGERPRINT_BAD_CHARACTER:
+            parts[part].insert(1, " ");
+            return join(parts);
+        case FINGERPRINT_WRONG_SEPARATOR: {
+            // TAGS ends the fingerprint, anything after it is trailing data
+            if (part == FINGERPRINT_TAGS) return std::nullopt;
+            std::string fingerprint = parts[0];
+            for (size_t i = 1; i < parts.size(); ++i) {
+                char separator = SEPARATORS[i - 1];
+                if (i - 1 == part) separator = separator == '/' ? ':' : '/';
+                appendPart(fingerprint, separator, parts[i]);
+            }
+            return fingerprint;
+        }
+        case FINGERPRINT_MISSING_PART: {
+            // Something has to come before a part for it to be missing
+            if (part == FINGERPRINT_BRAND) return std::nullopt;
+            std::string fingerprint = parts[0];
+            for (size_t i = 1; i < part; ++i) appendPart(fingerprint, SEPARATORS[i - 1], parts[i]);
+            return fingerprint;
+        }
+        case FINGERPRINT_TRAILING_DATA:
+            // Earlier parts followed by more see a wrong separator or a bad character instead
+            if (part != FINGERPRINT_TAGS) return std::nullopt;
+            return join(parts) + "/extra";
+    }
+
+    return std::nullopt;
+}
+
+TEST(Fingerprint, SplitsValidFingerprint) {
+    FingerprintParts parts;
+
+    ASSERT_TRUE(splitFingerprint(VALID, parts));
+
+    for (size_t i = 0; i < FINGERPRINT_PART_COUNT; ++i) {
+        EXPECT_EQ(parts[i], PARTS[i]) << fingerprintPartName(static_cast<FingerprintPart>(i));
+        // Parts point into the input, nothing is copied
+        EXPECT_GE(parts[i].data(), VALID.data());
+        EXPECT_LE(parts[i].data() + parts[i].size(), VALID.data() + VALID.size());
+    }
+}
+
+// Both enums are uint8_t, which gtest would print as chars
+static void PrintTo(FingerprintError error, std::ostream *os) {
+    *os << fingerprintErrorName(error);
+}
+
+static void PrintTo(FingerprintPart part, std::ostream *os) {
+    *os << fingerprintPartName(part);
+}
+
+class FingerprintErrors
+        : public testing::TestWithParam<std::tuple<FingerprintError, FingerprintPart>> {
+};
+
+TEST_P(FingerprintErrors, ReportsErrorAndPart) {
+    auto [error, part] = GetParam();
+    auto fingerprint = breakFingerprint(error, part);
+
+    if (!fingerprint) GTEST_SKIP() << "Can't happen in " << fingerprintPartName(part);
+
+    FingerprintParts parts;
+    auto result = splitFingerprint(*fingerprint, parts);
+
+    EXPECT_EQ(result.error, error) << *fingerprint;
+    EXPECT_EQ(result.part, part) << *fingerprint;
+    EXPECT_FALSE(result);
+}
+
+static std::string errorTestName(const testing::TestParamInfo<FingerprintErrors::ParamType> &info) {
+    static constexpr const char *ERRORS[] = {
+            "Ok", "EmptyPart", "BadCharacter", "WrongSeparator", "MissingPart", "TrailingData",
+    };
+    auto [error, part] = info.param;
+    return std::string(fingerprintPartName(part)) + "_" + ERRORS[error];
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        AllParts, FingerprintErrors,
+        testing::Combine(testing::Values(FINGERPRINT_EMPTY_PART, FINGERPRINT_BAD_CHARACTER,
+                                         FINGERPRINT_WRONG_SEPARATOR, FINGERPRINT_MISSING_PART,
+                                         FINGERPRINT_TRAILING_DATA),
+                         testing::Range(FINGERPRINT_BRAND, FINGERPRINT_PART_COUNT,
+                                        FingerprintPart(1))),
+        errorTestName);
+
+TEST(Fingerprint, OnlyTheDocumentedCombinationsAreUnreachable) {
+    // WRONG_SEPARATOR in TAGS, MISSING_PART in BRAND and TRAILING_DATA outside TAGS
+    size_t reachable = 0;
+
+    for (int error = FINGERPRINT_EMPTY_PART; error <= FINGERPRINT_TRAILING_DATA; ++error) {
+        for (int part = 0; part < FINGERPRINT_PART_COUNT; ++part) {
+            reachable += breakFingerprint(static_cast<FingerprintError>(error),
+                                          static_cast<FingerprintPart>(part)).has_value();
+        }
+    }
+
+    EXPECT_EQ(reachable, 8u + 8u + 7u + 7u + 1u);
+}
+
+TEST(Fingerprint, RejectsEdgeCases) {
+    FingerprintParts parts;
+
+    EXPECT_EQ(splitFingerprint("", parts).error, FINGERPRINT_EMPTY_PART);
+    EXPECT_EQ(splitFingerprint("google", parts).error, FINGERPRINT_MISSING_PART);
+    EXPECT_EQ(splitFingerprint(VALID + ":", parts).error, FINGERPRINT_TRAILING_DATA);
+    EXPECT_EQ(splitFingerprint(VALID + "\n", parts).error, FINGERPRINT_BAD_CHARACTER);
+    EXPECT_EQ(splitFingerprint("\x7f" + VALID, parts).error, FINGERPRINT_BAD_CHARACTER);
+    EXPECT_EQ(splitFingerprint("g\xC3\xA9" + VALID, parts).error, FINGERPRINT_BAD_CHARACTER);
+    EXPECT_EQ(splitFingerprint(std::string("goo\0gle", 7) + VALID.substr(6), parts).error,
+              FINGERPRINT_BAD_CHARACTER);
+
+    // A trailing separator leaves the next part empty, not missing
+    auto result = splitFingerprint("google/", parts);
+    EXPECT_EQ(result.error, FINGERPRINT_EMPTY_PART);
+    EXPECT_EQ(result.part, FINGERPRINT_PRODUCT);
+}
+
+TEST(Fingerprint, Names) {
+    EXPECT_STREQ(fingerprintPartName(FINGERPRINT_INCREMENTAL), "INCREMENTAL");
+    EXPECT_STREQ(fingerprintPartName(FINGERPRINT_PART_COUNT), "?");
+    EXPECT_STREQ(fingerprintErrorName(FINGERPRINT_MISSING_PART), "missing");
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "flatjson.hpp"
+
+// Keeps the buffer alive, the parsed views point into it
+struct Parsed {
+    std::string buffer;
+    PifJson json;
+    bool ok;
+
+    explicit Parsed(std::string text) : buffer(std::move(text)) {
+        ok = parsePifJson(std::span(buffer.data(), buffer.size()), json);
+    }
+
+    std::string_view field(std::string_view key) const {
+        auto entry = json.fields.find(key);
+        return entry ? entry->value : "<missing>";
+    }
+};
+
+TEST(FlatJson, ParsesPifJson) {
+    Parsed parsed(R"({
+      "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+      "MANUFACTURER": "Google",
+      "MODEL": "Pixel 6",
+      "SECURITY_PATCH": "2025-04-05"
+    })");
+
+    ASSERT_TRUE(parsed.ok);
+    ASSERT_EQ(parsed.json.fields.size(), 4u);
+    // File order is kept
+    EXPECT_EQ(parsed.json.fields[0].key, "FINGERPRINT");
+    EXPECT_EQ(parsed.json.fields[3].key, "SECURITY_PATCH");
+    EXPECT_EQ(parsed.field("MODEL"), "Pixel 6");
+    EXPECT_FALSE(parsed.json.spoofProvider);
+    EXPECT_EQ(parsed.json.mistyped.size(), 0u);
+}
+
+TEST(FlatJson, EmptyObject) {
+    EXPECT_TRUE(Parsed("{}").ok);
+    EXPECT_TRUE(Parsed(" \n{ }\n ").ok);
+}
+
+TEST(FlatJson, SkipsByteOrderMark) {
+    Parsed parsed("\xEF\xBB\xBF{\"MODEL\": \"Pixel 6\"}");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.field("MODEL"), "Pixel 6");
+    // Only at the very start
+    EXPECT_FALSE(Parsed(" \xEF\xBB\xBF{}").ok);
+    EXPECT_FALSE(Parsed("\xEF\xBB{}").ok);
+}
+
+TEST(FlatJson, DecodesEscapes) {
+    Parsed parsed(R"({"A": "q\"b\\s\/n\nt\tr\rb\bf\f", "B": "Aé€", "C": "😀"})");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.field("A"), "q\"b\\s/n\nt\tr\rb\bf\f");
+    EXPECT_EQ(parsed.field("B"), "A\xC3\xA9\xE2\x82\xAC");
+    EXPECT_EQ(parsed.field("C"), "\xF0\x9F\x98\x80");
+}
+
+TEST(FlatJson, EscapedKeys) {
+    Parsed parsed(R"({"\u004dODEL": "x", "B\"Q": "y"})");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.field("MODEL"), "x");
+    EXPECT_EQ(parsed.field("B\"Q"), "y");
+}
+
+TEST(FlatJson, RejectsBadEscapes) {
+    EXPECT_FALSE(Parsed(R"({"A": "\x41"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A": "\u00G1"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A": "\u00"})").ok);
+    // Lone and reversed surrogates
+    EXPECT_FALSE(Parsed(R"({"A": "\ud83d"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A": "\ud83dx"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A": "\ude00"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A": "\ud83dA"})").ok);
+    EXPECT_FALSE(Parsed("{\"A\": \"tab\there\"}").ok);
+    // NUL would truncate the value, in keys as well
+    EXPECT_FALSE(Parsed(R"({"A": "x\u0000y"})").ok);
+    EXPECT_FALSE(Parsed(R"({"A\u0000B": "x"})").ok);
+    EXPECT_TRUE(Parsed(R"({"A": "\u0001"})").ok);
+}
+
+TEST(FlatJson, AllowsComments) {
+    Parsed parsed(R"(// pif.json
+    {
+      /* the model */ "MODEL": "Pixel 6", // trailing
+      "BRAND": /* inline */ "google"
+    }
+    // done)");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.field("MODEL"), "Pixel 6");
+    EXPECT_EQ(parsed.field("BRAND"), "google");
+
+    EXPECT_FALSE(Parsed(R"({"MODEL": "x"} /* unterminated)").ok);
+    EXPECT_FALSE(Parsed(R"({"MODEL": "x"} / )").ok);
+}
+
+TEST(FlatJson, ReadsFlagsAndSdkInt) {
+    Parsed parsed(R"({"spoofProvider": false, "spoofProps": true, "spoofSignature": true,
+                      "DEBUG": false, "DEVICE_INITIAL_SDK_INT": 32})");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.json.spoofProvider, false);
+    EXPECT_EQ(parsed.json.spoofProps, true);
+    EXPECT_EQ(parsed.json.spoofSignature, true);
+    EXPECT_EQ(parsed.json.debug, false);
+    EXPECT_EQ(parsed.json.deviceInitialSdkInt, "32");
+    EXPECT_EQ(parsed.json.fields.size(), 0u);
+
+    EXPECT_EQ(Parsed(R"({"DEVICE_INITIAL_SDK_INT": "25"})").json.deviceInitialSdkInt, "25");
+}
+
+TEST(FlatJson, SetsAsideMistypedValues) {
+    Parsed parsed(R"({"spoofProvider": "yes", "MODEL": 6, "BRAND": null, "ID": [1, {"a": 2}],
+                      "DEVICE_INITIAL_SDK_INT": 32.5, "PROPS": "none", "TYPE": "user"})");
+
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_FALSE(parsed.json.spoofProvider);
+    EXPECT_FALSE(parsed.json.deviceInitialSdkInt);
+    EXPECT_EQ(parsed.json.fields.size(), 1u);
+
+    auto type = [&](std::string_view key) {
+        auto entry = parsed.json.mistyped.find(key);
+        return entry ? entry->value : "<missing>";
+    };
+
+    EXPECT_EQ(type("spoofProvider"), "string");
+    EXPECT_EQ(type("MODEL"), "number");
+    EXPECT_EQ(type("BRAND"), "null");
+    EXPECT_EQ(type("ID"), "object or array");
+    EXPECT_EQ(type("DEVICE_INITIAL_SDK_INT"), "number");
+    EXPECT_EQ(type("PROPS"), "string");
+}
+
+TEST(FlatJson, ReadsProps) {
+    Parsed parsed(R"({"PROPS": {"ro.boot.flash.locked": "1", "*.security_patch": "2025-04-05",
+                                "ro.debuggable": 0, "persist.sys.x": {"nested": true}},
+                      "MODEL": "x"})");
+
+    ASSERT_TRUE(parsed.ok);
+    ASSERT_EQ(parsed.json.props.size(), 2u);
+    EXPECT_EQ(parsed.json.props[0].key, "ro.boot.flash.locked");
+    EXPECT_EQ(parsed.json.props[1].value, "2025-04-05");
+    ASSERT_EQ(parsed.json.propsMistyped.size(), 2u);
+    EXPECT_EQ(parsed.json.propsMistyped.find("ro.debuggable")->value, "number");
+    EXPECT_EQ(parsed.json.propsMistyped.find("persist.sys.x")->value, "object or array");
+    EXPECT_EQ(parsed.field("MODEL"), "x");
+
+    EXPECT_TRUE(Parsed(R"({"PROPS": {}})").ok);
+    EXPECT_FALSE(Parsed(R"({"PROPS": {"a": "b",}})").ok);
+    EXPECT_FALSE(Parsed(R"({"PROPS": {"a" "b"}})").ok);
+}
+
+TEST(FlatJson, LaterDuplicatesWin) {
+    Parsed parsed(R"({"MODEL": "first", "BRAND": "b", "MODEL": "second"})");
+
+    ASSERT_TRUE(parsed.ok);
+    ASSERT_EQ(parsed.json.fields.size(), 2u);
+    EXPECT_EQ(parsed.json.fields[0].value, "second");
+}
+
+TEST(FlatJson, KeepsEntriesPastTheInlineOnes) {
+    std::string text = "{";
+    for (int i = 0; i < 100; ++i) {
+        if (i) text += ',';
+        text += "\"KEY" + std::to_string(i) + "\": \"" + std::to_string(i) + "\"";
+    }
+    text += "}";
+
+    Parsed parsed(text);
+
+    ASSERT_TRUE(parsed.ok);
+    ASSERT_EQ(parsed.json.fields.size(), 100u);
+    EXPECT_EQ(parsed.json.fields[99].value, "99");
+    EXPECT_EQ(parsed.field("KEY31"), "31");
+    EXPECT_EQ(parsed.field("KEY32"), "32");
+}
+
+TEST(FlatJson, LimitsNesting) {
+    auto nested = [](int depth) {
+        return "{\"A\": " + std::string(depth, '[') + std::string(depth, ']') + "}";
+    };
+
+    EXPECT_TRUE(Parsed(nested(64)).ok);
+    EXPECT_FALSE(Parsed(nested(65)).ok);
+    EXPECT_FALSE(Parsed(nested(100000)).ok);
+}
+
+TEST(FlatJson, RejectsMalformedInput) {
+    for (const char *text: {
+            "", " ", "[]", "\"MODEL\"", "{", "{\"MODEL\"", "{\"MODEL\":", "{\"MODEL\": \"x\"",
+            "{\"MODEL\": \"x\",}", "{\"MODEL\" \"x\"}", "{\"MODEL\": \"x\" \"BRAND\": \"y\"}",
+            "{MODEL: \"x\"}", "{'MODEL': 'x'}", "{\"MODEL\": \"x\"} {}", "{\"MODEL\": \"x\"}x",
+            "{\"A\": tru}", "{\"A\": nul}", "{\"A\": -}", "{\"A\": 1.}", "{\"A\": 1e}",
+            "{\"A\": [1, 2}", "{\"A\": {\"b\" 1}}", "{\"A\": [1,]}", "{,}",
+    }) {
+        EXPECT_FALSE(Parsed(text).ok) << text;
+    }
+}
+
+TEST(FlatJson, RejectsEveryTruncation) {
+    std::string text = R"({"MODEL": "Pixel 6", "PROPS": {"a": "b"}, "X": [1, {"y": 2.5e3}]})";
+    ASSERT_TRUE(Parsed(text).ok);
+
+    for (size_t size = 0; size < text.size(); ++size) {
+        EXPECT_FALSE(Parsed(text.substr(0, size)).ok) << size;
+    }
+}
+
+TEST(FlatJson, AppendsEscapedStrings) {
+    std::string value = "a\"b\\c\n\x01 é";
+    std::vector<uint8_t> out;
+    appendJsonString(out, value);
+
+    std::string quoted(out.begin(), out.end());
+    EXPECT_EQ(quoted, "\"a\\\"b\\\\c\\u000a\\u0001 é\"");
+
+    // And reads back as the same string
+    Parsed parsed("{\"K\": " + quoted + "}");
+    ASSERT_TRUE(parsed.ok);
+    EXPECT_EQ(parsed.field("K"), value);
+}
@@ -0,0 +1,30 @@
+#include <cstdlib>
+#include <string>
+#include "fingerprint.hpp"
+
+// libFuzzer entry point, also driven by fuzz_replay.cpp over tests/corpus/fingerprint
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    std::string_view input(reinterpret_cast<const char *>(data), size);
+    FingerprintParts parts;
+    auto result = splitFingerprint(input, parts);
+
+    if (result.part >= FINGERPRINT_PART_COUNT) abort();
+
+    if (!result) return 0;
+
+    // A valid fingerprint is its parts joined by the separators, each one non-empty
+    constexpr char SEPARATORS[] = "//://:/";
+    std::string joined(parts[0]);
+
+    for (size_t i = 0; i < FINGERPRINT_PART_COUNT; ++i) {
+        if (parts[i].empty()) abort();
+        if (parts[i].data() < input.data() ||
+            parts[i].data() + parts[i].size() > input.data() + input.size())
+            abort();
+        if (i > 0) (joined += SEPARATORS[i - 1]) += parts[i];
+    }
+
+    if (joined != input) abort();
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Runs a fuzz target over corpus files or directories, for compilers without libFuzzer
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void replay(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data{std::istreambuf_iterator<char>(file), {}};
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+}
+
+int main(int argc, char **argv) {
+    size_t count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::filesystem::path path(argv[i]);
+
+        if (std::filesystem::is_directory(path)) {
+            for (auto &entry: std::filesystem::directory_iterator(path)) {
+                replay(entry.path());
+                ++count;
+            }
+        } else if (std::filesystem::exists(path)) {
+            replay(path);
+            ++count;
+        } else {
+            fprintf(stderr, "%s doesn't exist\n", argv[i]);
+            return 1;
+        }
+    }
+
+    printf("Replayed %zu inputs\n", count);
+    return count ? 0 : 1;
+}
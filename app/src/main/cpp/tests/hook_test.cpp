@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hook.hpp"
+
+// A property as the fake __system_property_read_callback sees it
+struct FakeProp {
+    const char *name;
+    const char *value;
+    std::atomic<uint32_t> serial{0};
+};
+
+static const prop_info *asPropInfo(FakeProp &prop) {
+    return reinterpret_cast<const prop_info *>(&prop);
+}
+
+static std::atomic<int> originalCalls{0};
+
+static void fakeReadCallback(const prop_info *pi, T_Callback callback, void *cookie) {
+    ++originalCalls;
+    if (!pi || !callback) return;
+    auto *prop = reinterpret_cast<const FakeProp *>(pi);
+    callback(cookie, prop->name, prop->value, prop->serial.load(std::memory_order_relaxed));
+}
+
+struct Read {
+    std::string name;
+    std::string value;
+    int calls = 0;
+};
+
+static void recordRead(void *cookie, const char *name, const char *value, uint32_t) {
+    auto *read = static_cast<Read *>(cookie);
+    read->name = name;
+    read->value = value;
+    ++read->calls;
+}
+
+class Hook : public testing::Test {
+protected:
+    void SetUp() override {
+        state = pifHookState();
+
+        PropRuleSource rules[] = {
+                {"*.security_patch", "2025-04-05"},
+                {"*api_level", "32"},
+                {"init.svc.adbd", "stopped"},
+                {"ro.build.tags", ""},
+        };
+        matcher = buildPropMatcher(rules);
+        ASSERT_TRUE(parsePropMatcher(matcher));
+        state->props = matcher.data();
+        state->propsSize = matcher.size();
+        state->original = fakeReadCallback;
+        state->stats = nullptr;
+        state->debug = false;
+    }
+
+    Read read(FakeProp &prop) {
+        Read result;
+        state->replacement(asPropInfo(prop), recordRead, &result);
+        return result;
+    }
+
+    HookState *state = nullptr;
+    std::vector<uint8_t> matcher;
+};
+
+TEST_F(Hook, SpoofsMatchedProperties) {
+    FakeProp patch{"ro.build.version.security_patch", "2020-01-01"};
+    FakeProp sdk{"ro.product.first_api_level", "29"};
+    FakeProp adbd{"init.svc.adbd", "running"};
+    FakeProp model{"ro.product.model", "Pixel 6"};
+    FakeProp tags{"ro.build.tags", "test-keys"};
+
+    EXPECT_EQ(read(patch).value, "2025-04-05");
+    EXPECT_EQ(read(sdk).value, "32");
+    EXPECT_EQ(read(adbd).value, "stopped");
+    EXPECT_EQ(read(model).value, "Pixel 6");
+    // An empty value turns the rule off
+    EXPECT_EQ(read(tags).value, "test-keys");
+
+    Read result = read(patch);
+    EXPECT_EQ(result.name, "ro.build.version.security_patch");
+    EXPECT_EQ(result.calls, 1);
+}
+
+TEST_F(Hook, ChangedValueIsDecidedAgain) {
+    FakeProp adbd{"init.svc.adbd", "stopped"};
+
+    EXPECT_EQ(read(adbd).value, "stopped");
+
+    adbd.value = "running";
+    adbd.serial = 2;
+    EXPECT_EQ(read(adbd).value, "stopped");
+}
+
+TEST_F(Hook, PassesNullArgumentsThrough) {
+    int before = originalCalls;
+
+    state->replacement(nullptr, recordRead, nullptr);
+    FakeProp prop{"ro.x", "y"};
+    state->replacement(asPropInfo(prop), nullptr, nullptr);
+
+    EXPECT_EQ(originalCalls - before, 2);
+}
+
+TEST_F(Hook, RecordsStats) {
+    auto stats = std::make_unique<PropStats>();
+    state->stats = stats.get();
+
+    FakeProp patch{"ro.build.version.security_patch", "2020-01-01"};
+    FakeProp model{"ro.product.model", "Pixel 6"};
+    for (int i = 0; i < 3; ++i) read(patch);
+    read(model);
+
+    state->stats = nullptr;
+
+    uint32_t hits = 0, overrides = 0;
+    for (auto &slot: stats->slots) {
+        hits += slot.hits;
+        overrides += slot.overrides;
+    }
+    EXPECT_EQ(hits, 4u);
+    EXPECT_EQ(overrides, 3u);
+}
+
+// Reads on many threads, each with its own callback and cookie. Each read must reach exactly its
+// own callback once, with the spoofed value when a rule matches.
+static std::atomic<long> crossedCallbacks{0};
+
+struct ThreadCookie {
+    int id;
+    long calls = 0;
+    long wrongValues = 0;
+};
+
+template<int N>
+static void threadCallback(void *cookie, const char *name, const char *value, uint32_t) {
+    auto *thread = static_cast<ThreadCookie *>(cookie);
+    if (thread->id != N) ++crossedCallbacks;
+    ++thread->calls;
+
+    bool spoofed = strstr(name, "security_patch") != nullptr;
+    if (spoofed != (strcmp(value, "2025-04-05") == 0)) ++thread->wrongValues;
+}
+
+TEST_F(Hook, ConcurrentReadsKeepTheirCallbacks) {
+    constexpr int THREADS = 8, READS = 50000;
+    static constexpr T_Callback CALLBACKS[THREADS] = {
+            threadCallback<0>, threadCallback<1>, threadCallback<2>, threadCallback<3>,
+            threadCallback<4>, threadCallback<5>, threadCallback<6>, threadCallback<7>,
+    };
+
+    auto stats = std::make_unique<PropStats>();
+    state->stats = stats.get();
+
+    FakeProp props[] = {
+            {"ro.build.version.security_patch", "2020-01-01"},
+            {"ro.vendor.build.security_patch", "2020-01-01"},
+            {"ro.hardware", "oriole"},
+            {"persist.sys.locale", "en-US"},
+    };
+
+    std::vector<ThreadCookie> cookies(THREADS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; ++t) {
+        cookies[t].id = t;
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < READS; ++i) {
+                state->replacement(asPropInfo(props[i % std::size(props)]), CALLBACKS[t],
+                                   &cookies[t]);
+            }
+        });
+    }
+
+    for (auto &thread: threads) thread.join();
+    state->stats = nullptr;
+
+    EXPECT_EQ(crossedCallbacks.load(), 0);
+    for (auto &cookie: cookies) {
+        EXPECT_EQ(cookie.calls, READS);
+        EXPECT_EQ(cookie.wrongValues, 0);
+    }
+
+    uint32_t hits = 0;
+    for (auto &slot: stats->slots) hits += slot.hits;
+    EXPECT_EQ(hits + stats->dropped, static_cast<uint32_t>(THREADS * READS));
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "fakejni.hpp"
+#include "jstrings.hpp"
+
+static FakeEnv env;
+
+TEST(JStrings, EndsWith) {
+    FakeString gms{u"/data/user/0/com.google.android.gms"};
+    FakeString other{u"/data/user/0/com.example.gms"};
+    FakeString shorter{u"gms"};
+
+    EXPECT_TRUE(jstringEndsWith(&env, &gms, "/com.google.android.gms"));
+    EXPECT_TRUE(jstringEndsWith(&env, &gms, ""));
+    EXPECT_FALSE(jstringEndsWith(&env, &other, "/com.google.android.gms"));
+    EXPECT_FALSE(jstringEndsWith(&env, &shorter, "/com.google.android.gms"));
+    EXPECT_FALSE(jstringEndsWith(&env, static_cast<FakeString *>(nullptr), "gms"));
+}
+
+TEST(JStrings, NonAsciiTailNeverMatches) {
+    // Both encode to more bytes than the suffix has, the tail is still read safely
+    FakeString accented{u"/data/user/0/com.google.android.gmé"};
+    FakeString wide{u"/data/user/0/中中中中中中中中中中"};
+    FakeString nul{std::u16string(u"/com.google.android.gms") + u'\0'};
+
+    EXPECT_FALSE(jstringEndsWith(&env, &accented, "/com.google.android.gms"));
+    EXPECT_FALSE(jstringEndsWith(&env, &wide, "/com.google.android.gms"));
+    EXPECT_FALSE(jstringEndsWith(&env, &nul, "/com.google.android.gms"));
+}
+
+TEST(JStrings, LongSuffixIsRejected) {
+    std::u16string path(200, u'a');
+    FakeString str{path};
+
+    EXPECT_TRUE(jstringEndsWith(&env, &str, std::string(64, 'a')));
+    EXPECT_FALSE(jstringEndsWith(&env, &str, std::string(65, 'a')));
+}
+
+TEST(JStrings, Equals) {
+    FakeString unstable{u"com.google.android.gms.unstable"};
+    FakeString persistent{u"com.google.android.gms.persistent"};
+    FakeString prefixed{u"x.com.google.android.gms.unstable"};
+
+    EXPECT_TRUE(jstringEquals(&env, &unstable, "com.google.android.gms.unstable"));
+    EXPECT_FALSE(jstringEquals(&env, &persistent, "com.google.android.gms.unstable"));
+    EXPECT_FALSE(jstringEquals(&env, &prefixed, "com.google.android.gms.unstable"));
+    EXPECT_FALSE(jstringEquals(&env, static_cast<FakeString *>(nullptr), "x"));
+}
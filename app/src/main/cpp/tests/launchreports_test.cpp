@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "launchreports.hpp"
+
+static LaunchReport reportWithId(uint32_t id) {
+    LaunchReport report;
+    report.roundTripUs = id;
+    return report;
+}
+
+TEST(LaunchReports, ChecksTheRegion) {
+    auto reports = std::make_unique<LaunchReports>();
+
+    EXPECT_TRUE(isLaunchReports(reports.get(), sizeof(LaunchReports)));
+    EXPECT_FALSE(isLaunchReports(reports.get(), sizeof(LaunchReports) - 4));
+
+    reports->version = LAUNCH_REPORTS_VERSION + 1;
+    EXPECT_FALSE(isLaunchReports(reports.get(), sizeof(LaunchReports)));
+}
+
+TEST(LaunchReports, TakesReportsOldestFirst) {
+    auto reports = std::make_unique<LaunchReports>();
+    LaunchReport out[LAUNCH_REPORT_SLOTS];
+
+    for (uint32_t id: {10, 20, 30}) ASSERT_TRUE(postLaunchReport(*reports, reportWithId(id)));
+
+    // Slots freed by a take are reused, the order comes from the sequence
+    ASSERT_EQ(takeLaunchReports(*reports, out), 3u);
+    for (uint32_t id: {40, 50}) ASSERT_TRUE(postLaunchReport(*reports, reportWithId(id)));
+    ASSERT_EQ(takeLaunchReports(*reports, out), 2u);
+    EXPECT_EQ(out[0].roundTripUs, 40u);
+    EXPECT_EQ(out[1].roundTripUs, 50u);
+    EXPECT_LT(out[0].sequence, out[1].sequence);
+
+    EXPECT_EQ(takeLaunchReports(*reports, out), 0u);
+}
+
+TEST(LaunchReports, DropsReportsWhenFull) {
+    auto reports = std::make_unique<LaunchReports>();
+    LaunchReport out[LAUNCH_REPORT_SLOTS];
+
+    for (uint32_t i = 0; i < LAUNCH_REPORT_SLOTS; ++i)
+        ASSERT_TRUE(postLaunchReport(*reports, reportWithId(i)));
+
+    EXPECT_FALSE(postLaunchReport(*reports, reportWithId(100)));
+    EXPECT_EQ(reports->dropped.load(), 1u);
+
+    ASSERT_EQ(takeLaunchReports(*reports, out), static_cast<size_t>(LAUNCH_REPORT_SLOTS));
+    for (uint32_t i = 0; i < LAUNCH_REPORT_SLOTS; ++i) EXPECT_EQ(out[i].roundTripUs, i);
+
+    EXPECT_TRUE(postLaunchReport(*reports, reportWithId(100)));
+}
+
+TEST(LaunchReports, ClampsPhaseCount) {
+    auto reports = std::make_unique<LaunchReports>();
+    LaunchReport out[LAUNCH_REPORT_SLOTS];
+
+    LaunchReport report;
+    report.phaseCount = 1000;
+    ASSERT_TRUE(postLaunchReport(*reports, report));
+
+    ASSERT_EQ(takeLaunchReports(*reports, out), 1u);
+    EXPECT_EQ(out[0].phaseCount, static_cast<uint32_t>(LAUNCH_REPORT_PHASES));
+}
+
+// Modules post while several companion threads take, every report must be taken exactly once
+TEST(LaunchReports, ConcurrentPostersAndTakers) {
+    constexpr uint32_t POSTERS = 4, REPORTS_PER_POSTER = 20000, TAKERS = 3;
+
+    auto reports = std::make_unique<LaunchReports>();
+    std::vector<std::atomic<uint32_t>> seen(POSTERS * REPORTS_PER_POSTER);
+    std::atomic<uint32_t> posted{0}, taken{0};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < TAKERS; ++t) {
+        threads.emplace_back([&] {
+            LaunchReport out[LAUNCH_REPORT_SLOTS];
+            while (true) {
+                bool finished = done.load();
+                size_t count = takeLaunchReports(*reports, out);
+                for (size_t i = 0; i < count; ++i) seen[out[i].roundTripUs].fetch_add(1);
+                taken.fetch_add(count);
+                if (finished && count == 0) break;
+            }
+        });
+    }
+
+    std::vector<std::thread> posters;
+
+    for (uint32_t t = 0; t < POSTERS; ++t) {
+        posters.emplace_back([&, t] {
+            for (uint32_t i = 0; i < REPORTS_PER_POSTER; ++i) {
+                if (postLaunchReport(*reports, reportWithId(t * REPORTS_PER_POSTER + i)))
+                    posted.fetch_add(1);
+            }
+        });
+    }
+
+    for (auto &thread: posters) thread.join();
+    done.store(true);
+    for (auto &thread: threads) thread.join();
+
+    EXPECT_EQ(posted.load() + reports->dropped.load(), POSTERS * REPORTS_PER_POSTER);
+    EXPECT_EQ(taken.load(), posted.load());
+    for (auto &count: seen) ASSERT_LE(count.load(), 1u);
+}
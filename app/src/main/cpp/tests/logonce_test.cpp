@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logonce.hpp"
+
+using testing::internal::CaptureStderr;
+using testing::internal::GetCapturedStderr;
+
+// Host builds log to stderr, one "D PIF: " line per message
+static std::map<std::string, int> loggedLines(const std::string &output) {
+    std::map<std::string, int> lines;
+    std::istringstream stream(output);
+    for (std::string line; std::getline(stream, line);) ++lines[line];
+    return lines;
+}
+
+TEST(LogOnce, LogsRepeatsOnlyInTheSummary) {
+    auto log = std::make_unique<LogOnce>();
+
+    CaptureStderr();
+    for (int i = 0; i < 5; ++i) log->log("[%s]: %s -> %s", "ro.build.id", "AP1A", "BP22");
+    log->log("[%s]: %s -> %s", "ro.build.tags", "test-keys", "release-keys");
+    auto first = loggedLines(GetCapturedStderr());
+
+    EXPECT_EQ(first.size(), 2u);
+    EXPECT_EQ(first["D PIF: [ro.build.id]: AP1A -> BP22"], 1);
+    EXPECT_EQ(first["D PIF: [ro.build.tags]: test-keys -> release-keys"], 1);
+
+    CaptureStderr();
+    log->flush();
+    auto summary = loggedLines(GetCapturedStderr());
+
+    ASSERT_EQ(summary.size(), 1u);
+    EXPECT_EQ(summary.begin()->first, "D PIF: [ro.build.id]: AP1A -> BP22 (4 more times)");
+
+    // Counts start over after a flush
+    CaptureStderr();
+    log->flush();
+    EXPECT_EQ(GetCapturedStderr(), "");
+}
+
+TEST(LogOnce, TellsArgumentsApart) {
+    auto log = std::make_unique<LogOnce>();
+
+    CaptureStderr();
+    log->log("ab%s%s", "a", "bc");
+    log->log("ab%s%s", "ab", "c");
+    log->log("plain");
+    log->log("plain");
+    auto lines = loggedLines(GetCapturedStderr());
+
+    // Same text, but not the same arguments
+    EXPECT_EQ(lines["D PIF: ababc"], 2);
+    EXPECT_EQ(lines["D PIF: plain"], 1);
+}
+
+TEST(LogOnce, CutsLongMessages) {
+    auto log = std::make_unique<LogOnce>();
+    std::string value(500, 'x');
+
+    CaptureStderr();
+    log->log("[%s]", value.c_str());
+    auto output = GetCapturedStderr();
+
+    EXPECT_EQ(output, "D PIF: [" + std::string(LOG_ONCE_MESSAGE_SIZE - 2, 'x') + "\n");
+}
+
+TEST(LogOnce, LimitsMessagesThatDoNotFit) {
+    auto log = std::make_unique<LogOnce>();
+    constexpr int MESSAGES = 1000;
+
+    CaptureStderr();
+    for (int i = 0; i < MESSAGES; ++i) log->log("value %s", std::to_string(i).c_str());
+    auto logged = loggedLines(GetCapturedStderr()).size();
+
+    // Every slot is taken and then a burst more, the rest is only counted
+    EXPECT_LE(logged, static_cast<size_t>(LOG_ONCE_SLOTS + LOG_ONCE_BURST));
+    EXPECT_GE(logged, static_cast<size_t>(LOG_ONCE_BURST));
+
+    CaptureStderr();
+    log->flush();
+    auto summary = GetCapturedStderr();
+
+    EXPECT_NE(summary.find("D PIF: " + std::to_string(MESSAGES - logged) +
+                           " more messages weren't logged"), std::string::npos);
+}
+
+TEST(LogOnce, ConcurrentRepeatsAreLoggedOnce) {
+    constexpr int THREADS = 8, ROUNDS = 10000, MESSAGES = 10;
+    auto log = std::make_unique<LogOnce>();
+    std::vector<std::string> values;
+    for (int i = 0; i < MESSAGES; ++i) values.push_back(std::to_string(i));
+
+    CaptureStderr();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < ROUNDS; ++i) log->log("[%s]", values[i % MESSAGES].c_str());
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    log->flush();
+    auto lines = loggedLines(GetCapturedStderr());
+
+    int repeats = 0;
+    for (int i = 0; i < MESSAGES; ++i) {
+        EXPECT_EQ(lines["D PIF: [" + values[i] + "]"], 1) << i;
+
+        std::string prefix = "D PIF: [" + values[i] + "] (";
+        for (auto &[line, count]: lines) {
+            if (line.starts_with(prefix)) repeats += std::stoi(line.substr(prefix.size()));
+        }
+    }
+
+    EXPECT_EQ(repeats, THREADS * ROUNDS - MESSAGES);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include "bytes.hpp"
+#include "config.hpp"
+#include "profiles.hpp"
+
+static ProfileSource profile(std::string name, std::string json) {
+    ConfigDiagnostics diagnostics;
+    auto config = compileConfig(std::span(json.data(), json.size()), diagnostics);
+    return {std::move(name), std::move(config)};
+}
+
+static ProfileSource device(std::string name, const char *product, const char *model) {
+    return profile(std::move(name), std::string(R"({"PRODUCT": ")") + product +
+                                    R"(", "MODEL": ")" + model + R"("})");
+}
+
+static std::map<std::string, std::string> fieldsOf(std::span<const uint8_t> record) {
+    std::map<std::string, std::string> fields;
+    ConfigView config;
+    if (!parseConfig(record, config)) return fields;
+    forEachConfigField(config, [&](const BuildField &field, const char *value) {
+        fields[field.name] = value;
+    });
+    return fields;
+}
+
+// Same as the store's key hash, to pick keys that land on the same slot
+static uint32_t keyHash(std::string_view key) {
+    uint32_t hash = 2166136261u;
+    for (char c: key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+TEST(ProfileStore, ConfigRoundTrip) {
+    std::vector<ProfileSource> profiles = {
+            profile("oriole", R"({
+              "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+              "MODEL": "Pixel 6",
+              "SECURITY_PATCH": "2025-04-05",
+              "PROPS": {"ro.boot.flash.locked": "1"}
+            })"),
+            device("husky", "husky_beta", "Pixel 8 Pro"),
+    };
+
+    auto store = buildProfileStore(profiles);
+    ASSERT_EQ(profileCount(store), 2u);
+
+    for (uint32_t i = 0; i < profiles.size(); ++i) {
+        auto record = profileConfig(store, i);
+        EXPECT_TRUE(std::ranges::equal(record, profiles[i].config)) << i;
+    }
+
+    // By file name, PRODUCT and MODEL
+    EXPECT_EQ(findProfile(store, "oriole"), 0);
+    EXPECT_EQ(findProfile(store, "oriole_beta"), 0);
+    EXPECT_EQ(findProfile(store, "Pixel 6"), 0);
+    EXPECT_EQ(findProfile(store, "husky"), 1);
+    EXPECT_EQ(findProfile(store, "husky_beta"), 1);
+    EXPECT_EQ(findProfile(store, "Pixel 8 Pro"), 1);
+
+    auto fields = fieldsOf(profileConfig(store, findProfile(store, "Pixel 6")));
+    EXPECT_EQ(fields["MODEL"], "Pixel 6");
+    EXPECT_EQ(fields["SECURITY_PATCH"], "2025-04-05");
+    EXPECT_EQ(fields["INCREMENTAL"], "13467521");
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(profileConfig(store, 0), config));
+    EXPECT_FALSE(config.props.empty());
+}
+
+TEST(ProfileStore, FirstProfileKeepsADuplicateKey) {
+    auto store = buildProfileStore({
+            device("a", "shared_product", "Model A"),
+            device("b", "shared_product", "Model B"),
+            device("a", "product_c", "Model C"),
+    });
+
+    ASSERT_EQ(profileCount(store), 3u);
+    EXPECT_EQ(findProfile(store, "shared_product"), 0);
+    EXPECT_EQ(findProfile(store, "a"), 0);
+    EXPECT_EQ(findProfile(store, "b"), 1);
+    // Still reachable by the keys it doesn't share
+    EXPECT_EQ(findProfile(store, "Model C"), 2);
+    EXPECT_EQ(findProfile(store, "product_c"), 2);
+}
+
+TEST(ProfileStore, FindsKeysThatCollide) {
+    // Two profiles make a 16 slot table, find names that all start probing at the same slot
+    std::vector<std::string> names;
+    uint32_t target = keyHash("p0") & 15;
+
+    for (int i = 0; names.size() < 4; ++i) {
+        std::string name = "p" + std::to_string(i);
+        if ((keyHash(name) & 15) == target) names.push_back(name);
+    }
+
+    auto store = buildProfileStore({
+            device(names[0], "product_0", "model_0"),
+            device(names[1], "product_1", "model_1"),
+    });
+
+    EXPECT_EQ(findProfile(store, names[0]), 0);
+    EXPECT_EQ(findProfile(store, names[1]), 1);
+    // Probes past both of them without finding a match
+    EXPECT_EQ(findProfile(store, names[2]), -1);
+    EXPECT_EQ(findProfile(store, names[3]), -1);
+}
+
+TEST(ProfileStore, MissingSelection) {
+    auto store = buildProfileStore({device("oriole", "oriole_beta", "Pixel 6")});
+
+    EXPECT_EQ(findProfile(store, "husky"), -1);
+    EXPECT_EQ(findProfile(store, ""), -1);
+    EXPECT_EQ(findProfile(store, "oriol"), -1);
+    EXPECT_TRUE(profileConfig(store, 1).empty());
+
+    auto empty = buildProfileStore({});
+    EXPECT_EQ(profileCount(empty), 0u);
+    EXPECT_EQ(findProfile(empty, "oriole"), -1);
+    EXPECT_TRUE(profileConfig(empty, 0).empty());
+}
+
+TEST(ProfileStore, UnparsableConfigHasNoKeys) {
+    ProfileSource broken{"broken", {1, 2, 3, 4}};
+    auto store = buildProfileStore({broken, device("oriole", "oriole_beta", "Pixel 6")});
+
+    ASSERT_EQ(profileCount(store), 2u);
+    EXPECT_EQ(findProfile(store, "broken"), -1);
+    EXPECT_EQ(findProfile(store, "oriole"), 1);
+}
+
+TEST(ProfileStore, RejectsDamagedStores) {
+    auto store = buildProfileStore({device("oriole", "oriole_beta", "Pixel 6")});
+
+    auto badMagic = store;
+    badMagic[0] ^= 0xFF;
+    EXPECT_EQ(profileCount(badMagic), 0u);
+    EXPECT_EQ(findProfile(badMagic, "oriole"), -1);
+
+    auto badVersion = store;
+    writeLE<uint16_t>(badVersion.data() + 4, PROFILE_STORE_VERSION + 1);
+    EXPECT_EQ(profileCount(badVersion), 0u);
+
+    // The header promises more slots than there are
+    EXPECT_EQ(profileCount(std::span(store).first(PROFILE_STORE_HEADER_SIZE + 8)), 0u);
+
+    // A record running past the end of the store isn't handed out
+    auto cut = std::span(store).first(store.size() - 1);
+    EXPECT_EQ(findProfile(cut, "oriole"), 0);
+    EXPECT_TRUE(profileConfig(cut, 0).empty());
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bytes.hpp"
+#include "config.hpp"
+#include "props.hpp"
+
+static std::string lookup(std::span<const uint8_t> matcher, std::string_view name) {
+    int32_t offset = findPropValue(matcher, name);
+    return offset < 0 ? "<none>" : propValue(matcher, offset);
+}
+
+static const PropRuleSource RULES[] = {
+        {"init.svc.adbd", "stopped"},
+        {"sys.usb.state", "mtp"},
+        {"*api_level", "21"},
+        {"*.security_patch", "2025-04-05"},
+        {"*.build.id", "BP22"},
+        {"ro.product.*", "prefix"},
+        {"ro.product.model*", "longer prefix"},
+        {"ro.*.fingerprint", "fingerprint"},
+        {"*debug*", "first glob"},
+        {"ro.?oo.bar", "second glob"},
+        {"ro.vendor.build.id", "exact"},
+        // Later rules replace earlier ones with the same pattern, empty values included
+        {"sys.usb.state", "adb"},
+        {"*.security_patch", ""},
+};
+
+TEST(PropMatcher, Precedence) {
+    auto matcher = buildPropMatcher(RULES);
+    ASSERT_TRUE(parsePropMatcher(matcher));
+
+    EXPECT_EQ(lookup(matcher, "init.svc.adbd"), "stopped");
+    EXPECT_EQ(lookup(matcher, "sys.usb.state"), "adb");
+    EXPECT_EQ(lookup(matcher, "ro.product.first_api_level"), "21");
+    EXPECT_EQ(lookup(matcher, "ro.build.version.security_patch"), "");
+    // Exact beats suffix, the longest suffix or prefix wins
+    EXPECT_EQ(lookup(matcher, "ro.vendor.build.id"), "exact");
+    EXPECT_EQ(lookup(matcher, "ro.system.build.id"), "BP22");
+    EXPECT_EQ(lookup(matcher, "ro.product.name"), "prefix");
+    EXPECT_EQ(lookup(matcher, "ro.product.model"), "longer prefix");
+    // Suffixes beat prefixes, prefixes beat globs
+    EXPECT_EQ(lookup(matcher, "ro.product.board_api_level"), "21");
+    EXPECT_EQ(lookup(matcher, "ro.product.debug"), "prefix");
+    // Globs in rule order
+    EXPECT_EQ(lookup(matcher, "ro.system.fingerprint"), "fingerprint");
+    EXPECT_EQ(lookup(matcher, "ro.debug.fingerprint"), "fingerprint");
+    EXPECT_EQ(lookup(matcher, "ro.debuggable"), "first glob");
+    EXPECT_EQ(lookup(matcher, "ro.foo.bar"), "second glob");
+
+    EXPECT_EQ(lookup(matcher, "ro.fooo.bar"), "<none>");
+    EXPECT_EQ(lookup(matcher, "persist.x"), "<none>");
+    EXPECT_EQ(lookup(matcher, ""), "<none>");
+}
+
+static bool hasTailTable(std::span<const uint8_t> matcher) {
+    return readLE<uint32_t>(matcher.data() + 32) != 0;
+}
+
+static const PropRuleSource LITERAL_RULES[] = {
+        {"init.svc.adbd", "stopped"},
+        {"sys.usb.state", "mtp"},
+        {"*api_level", "21"},
+        {"*.security_patch", "2025-04-05"},
+        {"*.build.id", "BP22"},
+        // Ends like *.build.id, both are looked up the long way
+        {"ro.vendor.build.id", "exact"},
+        {"ro.boot.flash.locked", ""},
+};
+
+// Exact names and suffixes only, so the tail table answers on its own and has to agree with
+// the tries and the exact table
+TEST(PropMatcher, TailTableAgreesWithTries) {
+    auto fast = buildPropMatcher(LITERAL_RULES);
+    ASSERT_TRUE(parsePropMatcher(fast));
+    EXPECT_TRUE(hasTailTable(fast));
+
+    // Any glob turns the tail table off
+    std::vector<PropRuleSource> rules(std::begin(LITERAL_RULES), std::end(LITERAL_RULES));
+    rules.push_back({"never?matched*", "x"});
+    auto slow = buildPropMatcher(rules);
+    ASSERT_TRUE(parsePropMatcher(slow));
+    EXPECT_FALSE(hasTailTable(slow));
+
+    for (const char *name: {"init.svc.adbd", "xinit.svc.adbd", "nit.svc.adbd", "sys.usb.state",
+                            "ro.product.first_api_level", "api_level", "pi_level",
+                            "ro.build.version.security_patch", ".security_patch",
+                            "security_patch", "ro.build.id", "ro.vendor.build.id",
+                            "xro.vendor.build.id", "ro.boot.flash.locked", "ro.hardware",
+                            "short", "", "persist.sys.usb.state"}) {
+        EXPECT_EQ(lookup(fast, name), lookup(slow, name)) << name;
+    }
+
+    EXPECT_EQ(lookup(fast, "ro.product.first_api_level"), "21");
+    EXPECT_EQ(lookup(fast, "ro.vendor.build.id"), "exact");
+    EXPECT_EQ(lookup(fast, "ro.system.build.id"), "BP22");
+    EXPECT_EQ(lookup(fast, "persist.sys.usb.state"), "<none>");
+}
+
+TEST(PropMatcher, ShortRulesHaveNoTailTable) {
+    PropRuleSource rules[] = {{"*.id", "x"}, {"init.svc.adbd", "stopped"}};
+    auto matcher = buildPropMatcher(rules);
+
+    ASSERT_TRUE(parsePropMatcher(matcher));
+    EXPECT_FALSE(hasTailTable(matcher));
+    EXPECT_EQ(lookup(matcher, "ro.build.id"), "x");
+}
+
+TEST(PropMatcher, NoRules) {
+    auto matcher = buildPropMatcher({});
+
+    ASSERT_TRUE(parsePropMatcher(matcher));
+    EXPECT_EQ(lookup(matcher, "ro.build.id"), "<none>");
+}
+
+static std::vector<uint8_t> exactRules(int count, std::vector<std::string> &names) {
+    for (int i = 0; i < count; ++i) names.push_back("vendor.x" + std::to_string(i));
+
+    std::vector<PropRuleSource> rules;
+    for (auto &name: names) rules.push_back({name, "v"});
+    return buildPropMatcher(rules);
+}
+
+TEST(PropMatcher, ManyRules) {
+    std::vector<std::string> names;
+    auto matcher = exactRules(1000, names);
+
+    ASSERT_TRUE(parsePropMatcher(matcher));
+    EXPECT_EQ(lookup(matcher, "vendor.x999"), "v");
+    EXPECT_EQ(lookup(matcher, "vendor.x1000"), "<none>");
+}
+
+TEST(PropMatcher, RefusesWhatDoesNotFit) {
+    std::vector<std::string> names;
+
+    EXPECT_TRUE(exactRules(5000, names).empty());
+}
+
+TEST(PropMatcher, RejectsTruncation) {
+    for (auto matcher: {buildPropMatcher(RULES), buildPropMatcher(LITERAL_RULES)}) {
+        for (size_t size = 0; size < matcher.size(); ++size) {
+            EXPECT_FALSE(parsePropMatcher(std::span(matcher).first(size))) << size;
+        }
+    }
+}
+
+// parsePropMatcher is all the hook checks, so any matcher it accepts must be safe to look up
+static void lookUpEveryBitFlip(const std::vector<uint8_t> &matcher) {
+    for (size_t i = 0; i < matcher.size(); ++i) {
+        for (int bit = 0; bit < 8; ++bit) {
+            auto corrupted = matcher;
+            corrupted[i] ^= 1 << bit;
+
+            if (!parsePropMatcher(corrupted)) continue;
+
+            for (const char *name: {"ro.product.first_api_level", "ro.foo.bar", "init.svc.adbd",
+                                    "ro.product.model", "ro.debuggable", "ro.vendor.build.id"}) {
+                int32_t offset = findPropValue(corrupted, name);
+                if (offset >= 0) {
+                    ASSERT_LT(static_cast<size_t>(offset), corrupted.size());
+                    EXPECT_LE(strlen(propValue(corrupted, offset)),
+                              corrupted.size() - offset);
+                }
+            }
+        }
+    }
+}
+
+TEST(PropMatcher, SurvivesEveryBitFlip) {
+    lookUpEveryBitFlip(buildPropMatcher(RULES));
+    // These get a tail table
+    lookUpEveryBitFlip(buildPropMatcher(LITERAL_RULES));
+}
+
+TEST(PropMatcher, GlobMatch) {
+    EXPECT_TRUE(globMatch("*", ""));
+    EXPECT_TRUE(globMatch("ro.*.id", "ro.build.id"));
+    EXPECT_TRUE(globMatch("ro.*.id", "ro..id"));
+    EXPECT_TRUE(globMatch("*a*b*", "xxaxxbxx"));
+    EXPECT_TRUE(globMatch("?", "x"));
+    EXPECT_FALSE(globMatch("?", ""));
+    EXPECT_FALSE(globMatch("ro.*.id", "ro.build.idx"));
+    EXPECT_FALSE(globMatch("a*b", "ac"));
+}
+
+TEST(PropMatcher, ClassifiesPatterns) {
+    PropRuleKind kind;
+
+    ASSERT_TRUE(classifyPropPattern("ro.build.id", kind));
+    EXPECT_EQ(kind, PROP_RULE_EXACT);
+    ASSERT_TRUE(classifyPropPattern("*.build.id", kind));
+    EXPECT_EQ(kind, PROP_RULE_SUFFIX);
+    ASSERT_TRUE(classifyPropPattern("ro.product.*", kind));
+    EXPECT_EQ(kind, PROP_RULE_PREFIX);
+    ASSERT_TRUE(classifyPropPattern("ro.*.id*", kind));
+    EXPECT_EQ(kind, PROP_RULE_GLOB);
+    ASSERT_TRUE(classifyPropPattern("ro.?", kind));
+    EXPECT_EQ(kind, PROP_RULE_GLOB);
+
+    EXPECT_FALSE(classifyPropPattern("", kind));
+    EXPECT_FALSE(classifyPropPattern("bad pattern", kind));
+    EXPECT_FALSE(classifyPropPattern("ro/build", kind));
+}
+
+TEST(PropMatcher, ConfigProps) {
+    std::string json = R"({
+      "FINGERPRINT": "google/oriole_beta/oriole:16/BP22.250325.012/13467521:user/release-keys",
+      "SECURITY_PATCH": "2025-04-05",
+      "DEVICE_INITIAL_SDK_INT": 32,
+      "PROPS": {
+        "ro.boot.verifiedbootstate": "green",
+        "*.build.id": "",
+        "bad pattern": "x",
+        "number": 1,
+        "*mid*": "y",
+        "long": "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789"
+      }
+    })";
+
+    ConfigDiagnostics diagnostics;
+    auto record = compileConfig(std::span(json.data(), json.size()), diagnostics);
+    // The bad pattern and the long value are errors, both are left out
+    EXPECT_EQ(diagnostics.status, CONFIG_STATUS_ERRORS);
+
+    ConfigView config;
+    ASSERT_TRUE(parseConfig(record, config));
+
+    EXPECT_EQ(lookup(config.props, "ro.boot.verifiedbootstate"), "green");
+    // PROPS replaces a built-in rule, an empty value turns it off
+    EXPECT_EQ(lookup(config.props, "ro.build.id"), "");
+    EXPECT_EQ(lookup(config.props, "ro.product.first_api_level"), "32");
+    EXPECT_EQ(lookup(config.props, "ro.vendor.build.security_patch"), "2025-04-05");
+    EXPECT_EQ(lookup(config.props, "sys.usb.state"), "mtp");
+    EXPECT_EQ(lookup(config.props, "amidb"), "y");
+    // Values longer than PROP_VALUE_MAX, bad patterns and mistyped values are left out
+    EXPECT_EQ(lookup(config.props, "long"), "<none>");
+    EXPECT_EQ(lookup(config.props, "number"), "<none>");
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+#include "protocol.hpp"
+
+class Protocol : public testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets), 0);
+    }
+
+    void TearDown() override {
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+
+    int sockets[2] = {-1, -1};
+    Arena arena{1 << 20};
+};
+
+static int tempFile(const char *content) {
+    char path[] = "/tmp/pif_protocol_XXXXXX";
+    int fd = mkstemp(path);
+    unlink(path);
+    write(fd, content, strlen(content));
+    return fd;
+}
+
+static ino_t inode(int fd) {
+    struct stat st{};
+    fstat(fd, &st);
+    return st.st_ino;
+}
+
+TEST_F(Protocol, MessageRoundTrip) {
+    std::vector<uint8_t> config(5000, 0x5A);
+    uint8_t buildId[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+    CompanionMessage message;
+    message.dexSize = 4;
+    message.reportsSize = 688;
+    message.libcOffset = 0x1234;
+    message.libcBuildId = buildId;
+    message.config = config;
+    message.flags = 7;
+    message.status = 1;
+
+    CompanionFds fds;
+    fds.dex = tempFile("dex\n");
+    fds.reports = tempFile("reports\n");
+
+    ASSERT_TRUE(sendMessage(sockets[0], fds, message, deadlineAfterMs(1000)));
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    ASSERT_TRUE(recvMessage(sockets[1], arena, received, receivedFds, deadlineAfterMs(1000)));
+
+    EXPECT_EQ(received.dexSize, 4u);
+    EXPECT_EQ(received.hookSize, 0u);
+    EXPECT_EQ(received.statsSize, 0u);
+    EXPECT_EQ(received.reportsSize, 688u);
+    EXPECT_EQ(received.libcOffset, 0x1234u);
+    EXPECT_TRUE(std::ranges::equal(received.libcBuildId, buildId));
+    EXPECT_TRUE(std::ranges::equal(received.config, config));
+    EXPECT_EQ(received.flags, 7u);
+    EXPECT_EQ(received.status, 1);
+
+    // Descriptors are matched to their size fields by order, missing ones leave no gap
+    EXPECT_EQ(inode(receivedFds.dex), inode(fds.dex));
+    EXPECT_EQ(receivedFds.hook, -1);
+    EXPECT_EQ(receivedFds.stats, -1);
+    EXPECT_EQ(inode(receivedFds.reports), inode(fds.reports));
+
+    for (int fd: {fds.dex, fds.reports, receivedFds.dex, receivedFds.reports}) close(fd);
+}
+
+TEST_F(Protocol, SizeWithoutDescriptorIsNotSent) {
+    CompanionMessage message;
+    message.dexSize = 100;
+
+    ASSERT_TRUE(sendMessage(sockets[0], {}, message, deadlineAfterMs(1000)));
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    ASSERT_TRUE(recvMessage(sockets[1], arena, received, receivedFds, deadlineAfterMs(1000)));
+
+    EXPECT_EQ(received.dexSize, 0u);
+    EXPECT_EQ(receivedFds.dex, -1);
+}
+
+TEST_F(Protocol, RequestRoundTrip) {
+    ModuleRequest request;
+    request.request = REQUEST_CONFIG;
+
+    ASSERT_TRUE(sendRequest(sockets[0], request, deadlineAfterMs(1000)));
+
+    std::vector<uint8_t> buffer;
+    ModuleRequest received;
+    ASSERT_TRUE(recvRequest(sockets[1], buffer, received, deadlineAfterMs(1000)));
+
+    EXPECT_EQ(received.request, REQUEST_CONFIG);
+}
+
+TEST_F(Protocol, RejectsCorruptedPayload) {
+    std::vector<uint8_t> config(64, 1);
+    CompanionMessage message;
+    message.config = config;
+
+    ASSERT_TRUE(sendMessage(sockets[0], {}, message, deadlineAfterMs(1000)));
+
+    // Flip a payload byte and relay the message through a second socket pair
+    uint8_t wire[4096];
+    ssize_t size = read(sockets[1], wire, sizeof(wire));
+    ASSERT_GT(size, PROTOCOL_HEADER_SIZE + 10);
+    wire[size - 10] ^= 0xFF;
+
+    int relay[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, relay), 0);
+    ASSERT_EQ(write(relay[0], wire, size), size);
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    EXPECT_FALSE(recvMessage(relay[1], arena, received, receivedFds, deadlineAfterMs(1000)));
+
+    close(relay[0]);
+    close(relay[1]);
+}
+
+TEST_F(Protocol, RejectsBadMagic) {
+    uint8_t header[PROTOCOL_HEADER_SIZE]{};
+    writeLE<uint32_t>(header, 0xDEADBEEF);
+    header[4] = PROTOCOL_VERSION;
+    ASSERT_EQ(write(sockets[0], header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    EXPECT_FALSE(recvMessage(sockets[1], arena, received, receivedFds, deadlineAfterMs(1000)));
+}
+
+TEST_F(Protocol, RejectsOversizedPayload) {
+    uint8_t header[PROTOCOL_HEADER_SIZE]{};
+    writeLE<uint32_t>(header, PROTOCOL_MAGIC);
+    header[4] = PROTOCOL_VERSION;
+    writeLE<uint32_t>(header + 8, PROTOCOL_MAX_PAYLOAD + 1);
+    ASSERT_EQ(write(sockets[0], header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    EXPECT_FALSE(recvMessage(sockets[1], arena, received, receivedFds, deadlineAfterMs(1000)));
+}
+
+TEST_F(Protocol, GivesUpAtTheDeadline) {
+    // Only half a header ever arrives
+    uint8_t header[PROTOCOL_HEADER_SIZE / 2]{};
+    ASSERT_EQ(write(sockets[0], header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+
+    CompanionMessage received;
+    CompanionFds receivedFds;
+    int64_t start = nowNs();
+
+    EXPECT_FALSE(recvMessage(sockets[1], arena, received, receivedFds, deadlineAfterMs(50)));
+    EXPECT_LT(nowNs() - start, 1000000000);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <cstdio>
+#include "symbols.hpp"
+
+TEST(Symbols, FindsLibcSymbols) {
+    EXPECT_EQ(findLibcSymbol("getpid"), dlsym(RTLD_DEFAULT, "getpid"));
+    EXPECT_EQ(findLibcSymbol("no_such_symbol_in_libc"), nullptr);
+}
+
+TEST(Symbols, CachedOffsetResolvesToTheSameAddress) {
+    LibcSymbol symbol;
+    ASSERT_TRUE(resolveLibcSymbol("getpid", symbol));
+
+    EXPECT_GT(symbol.buildIdSize, 0);
+    EXPECT_LE(symbol.buildIdSize, LIBC_BUILD_ID_MAX);
+
+    void *address = libcSymbolAddress({symbol.buildId, symbol.buildIdSize}, symbol.offset);
+    EXPECT_EQ(address, reinterpret_cast<void *>(&getpid));
+}
+
+TEST(Symbols, MissingSymbolIsNotResolved) {
+    LibcSymbol symbol;
+
+    EXPECT_FALSE(resolveLibcSymbol("no_such_symbol_in_libc", symbol));
+}
+
+TEST(Symbols, RejectsAnotherLibc) {
+    LibcSymbol symbol;
+    ASSERT_TRUE(resolveLibcSymbol("fopen", symbol));
+
+    uint8_t otherId[LIBC_BUILD_ID_MAX];
+    std::copy(std::begin(symbol.buildId), std::end(symbol.buildId), otherId);
+    otherId[0] ^= 0xFF;
+
+    EXPECT_EQ(libcSymbolAddress({otherId, symbol.buildIdSize}, symbol.offset), nullptr);
+    // A prefix of the right build ID isn't the right build ID
+    EXPECT_EQ(libcSymbolAddress({symbol.buildId, symbol.buildIdSize - 1u}, symbol.offset),
+              nullptr);
+    EXPECT_EQ(libcSymbolAddress({}, symbol.offset), nullptr);
+}
+
+TEST(Symbols, RejectsOffsetsOutsideLibcCode) {
+    LibcSymbol symbol;
+    ASSERT_TRUE(resolveLibcSymbol("fopen", symbol));
+    std::span<const uint8_t> buildId(symbol.buildId, symbol.buildIdSize);
+
+    EXPECT_EQ(libcSymbolAddress(buildId, 0), nullptr);
+    EXPECT_EQ(libcSymbolAddress(buildId, 1ull << 40), nullptr);
+    EXPECT_EQ(libcSymbolAddress(buildId, UINT64_MAX), nullptr);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "zip.hpp"
+#include "ziparchive.hpp"
+
+static bool hasTestEntry(const std::vector<uint8_t> &zip) {
+    return zipHasEntryContaining(zip.data(), zip.size(), "test");
+}
+
+TEST(Zip, FindsEntryName) {
+    EXPECT_TRUE(hasTestEntry(buildZip({{"releasekey.x509.pem", 1200}, {"testkey.x509.pem", 1200}})));
+    EXPECT_FALSE(hasTestEntry(buildZip({{"releasekey.x509.pem", 1200}})));
+    EXPECT_FALSE(hasTestEntry(buildZip({})));
+}
+
+TEST(Zip, LooksOnlyAtNames) {
+    // Local headers and file data aren't read, only the central directory
+    auto zip = buildZip({{"releasekey.x509.pem", 64}});
+    std::string_view needle = "test";
+    std::copy(needle.begin(), needle.end(), zip.begin() + 30 + 19);
+
+    EXPECT_FALSE(hasTestEntry(zip));
+}
+
+TEST(Zip, SkipsArchiveComment) {
+    // The EOCD is searched for up to the longest comment a ZIP can have
+    std::string comment(0xFFFF, 'c');
+    EXPECT_TRUE(hasTestEntry(buildZip({{"testkey.x509.pem", 10}}, comment)));
+    EXPECT_TRUE(hasTestEntry(buildZip({{"testkey.x509.pem", 10}}, "signed")));
+}
+
+TEST(Zip, RejectsTruncatedArchives) {
+    auto zip = buildZip({{"testkey.x509.pem", 100}});
+
+    // Every prefix loses at least the end of the EOCD, none may be read past
+    for (size_t size = 0; size < zip.size(); ++size) {
+        std::vector<uint8_t> truncated(zip.begin(), zip.begin() + size);
+        EXPECT_FALSE(hasTestEntry(truncated)) << size;
+    }
+}
+
+TEST(Zip, RejectsCentralDirectoryOutsideTheArchive) {
+    ZipLayout layout;
+    auto zip = buildZip({{"testkey.x509.pem", 100}}, {}, &layout);
+
+    auto badOffset = zip;
+    writeLE<uint32_t>(badOffset.data() + layout.eocdOffset + 16, zip.size() + 1);
+    EXPECT_FALSE(hasTestEntry(badOffset));
+
+    auto wrappingOffset = zip;
+    writeLE<uint32_t>(wrappingOffset.data() + layout.eocdOffset + 16, 0xFFFFFFFF);
+    EXPECT_FALSE(hasTestEntry(wrappingOffset));
+
+    auto badSize = zip;
+    writeLE<uint32_t>(badSize.data() + layout.eocdOffset + 12, zip.size());
+    EXPECT_FALSE(hasTestEntry(badSize));
+
+    EXPECT_TRUE(hasTestEntry(zip));
+}
+
+TEST(Zip, RejectsRecordsPastTheCentralDirectory) {
+    ZipLayout layout;
+    auto zip = buildZip({{"releasekey.x509.pem", 100}, {"testkey.x509.pem", 100}}, {},
+                        &layout);
+
+    // The first name claims to run into the second record
+    auto oversizedName = zip;
+    writeLE<uint16_t>(oversizedName.data() + layout.cdOffset + 28, 0xFFFF);
+    EXPECT_FALSE(hasTestEntry(oversizedName));
+
+    auto oversizedExtra = zip;
+    writeLE<uint16_t>(oversizedExtra.data() + layout.cdOffset + 30, 0xFFFF);
+    EXPECT_FALSE(hasTestEntry(oversizedExtra));
+
+    // More entries than the directory holds
+    ZipLayout singleLayout;
+    auto extraEntries = buildZip({{"releasekey.x509.pem", 100}}, {}, &singleLayout);
+    writeLE<uint16_t>(extraEntries.data() + singleLayout.eocdOffset + 10, 2);
+    EXPECT_FALSE(hasTestEntry(extraEntries));
+
+    auto badSignature = zip;
+    badSignature[layout.cdOffset] ^= 0xFF;
+    EXPECT_FALSE(hasTestEntry(badSignature));
+}
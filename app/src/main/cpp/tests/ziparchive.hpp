@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bytes.hpp"
+
+// Builds ZIP archives of stored entries, shared by zip_test.cpp and zip_bench.cpp.
+// CRCs are left at zero, nothing here checks them.
+struct ZipEntryInfo {
+    std::string name;
+    size_t dataSize = 0;
+};
+
+// Offsets of the pieces tests corrupt
+struct ZipLayout {
+    size_t cdOffset = 0;
+    size_t eocdOffset = 0;
+};
+
+inline void appendLE(std::vector<uint8_t> &out, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+inline std::vector<uint8_t> buildZip(const std::vector<ZipEntryInfo> &entries,
+                                     std::string_view comment = {},
+                                     ZipLayout *layout = nullptr) {
+    std::vector<uint8_t> zip;
+    std::vector<size_t> localOffsets;
+
+    for (const auto &entry: entries) {
+        localOffsets.push_back(zip.size());
+        appendLE(zip, 0x04034b50, 4);
+        appendLE(zip, 10, 2); // version needed
+        appendLE(zip, 0, 2); // flags
+        appendLE(zip, 0, 2); // stored
+        appendLE(zip, 0, 4); // time and date
+        appendLE(zip, 0, 4); // CRC
+        appendLE(zip, entry.dataSize, 4);
+        appendLE(zip, entry.dataSize, 4);
+        appendLE(zip, entry.name.size(), 2);
+        appendLE(zip, 0, 2);
+        zip.insert(zip.end(), entry.name.begin(), entry.name.end());
+        zip.insert(zip.end(), entry.dataSize, '-');
+    }
+
+    size_t cdOffset = zip.size();
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        appendLE(zip, 0x02014b50, 4);
+        appendLE(zip, 0x031e, 2); // made by
+        appendLE(zip, 10, 2);
+        appendLE(zip, 0, 2);
+        appendLE(zip, 0, 2);
+        appendLE(zip, 0, 4);
+        appendLE(zip, 0, 4);
+        appendLE(zip, entries[i].dataSize, 4);
+        appendLE(zip, entries[i].dataSize, 4);
+        appendLE(zip, entries[i].name.size(), 2);
+        appendLE(zip, 0, 2); // extra
+        appendLE(zip, 0, 2); // comment
+        appendLE(zip, 0, 2); // disk
+        appendLE(zip, 0, 2); // internal attributes
+        appendLE(zip, 0x81a40000, 4); // -rw-r--r--
+        appendLE(zip, localOffsets[i], 4);
+        zip.insert(zip.end(), entries[i].name.begin(), entries[i].name.end());
+    }
+
+    size_t eocdOffset = zip.size();
+
+    appendLE(zip, 0x06054b50, 4);
+    appendLE(zip, 0, 2);
+    appendLE(zip, 0, 2);
+    appendLE(zip, entries.size(), 2);
+    appendLE(zip, entries.size(), 2);
+    appendLE(zip, eocdOffset - cdOffset, 4);
+    appendLE(zip, cdOffset, 4);
+    appendLE(zip, comment.size(), 2);
+    zip.insert(zip.end(), comment.begin(), comment.end());
+
+    if (layout) *layout = {cdOffset, eocdOffset};
+    return zip;
+}
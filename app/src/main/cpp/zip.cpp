@@ -0,0 +1,54 @@
+#include "bytes.hpp"
+#include "zip.hpp"
+
+bool zipHasEntryContaining(const uint8_t *data, size_t size, std::string_view needle) {
+    constexpr uint32_t EOCD_SIGNATURE = 0x06054b50;
+    constexpr uint32_t CD_SIGNATURE = 0x02014b50;
+    constexpr size_t EOCD_SIZE = 22;
+    constexpr size_t CD_HEADER_SIZE = 46;
+
+    if (size < EOCD_SIZE) return false;
+
+    // EOCD is at the end of the archive, followed by a comment of at most 64 KiB
+    size_t minEocd = size > EOCD_SIZE + 0xFFFF ? size - EOCD_SIZE - 0xFFFF : 0;
+    const uint8_t *eocd = nullptr;
+
+    for (size_t pos = size - EOCD_SIZE + 1; pos-- > minEocd;) {
+        if (readLE<uint32_t>(data + pos) == EOCD_SIGNATURE) {
+            eocd = data + pos;
+            break;
+        }
+    }
+
+    if (!eocd) return false;
+
+    uint16_t entries = readLE<uint16_t>(eocd + 10);
+    size_t cdSize = readLE<uint32_t>(eocd + 12);
+    size_t cdOffset = readLE<uint32_t>(eocd + 16);
+
+    if (cdOffset > size || cdSize > size - cdOffset) return false;
+
+    const uint8_t *ptr = data + cdOffset;
+    const uint8_t *end = ptr + cdSize;
+
+    for (uint16_t i = 0; i < entries; ++i) {
+        if (end - ptr < static_cast<ptrdiff_t>(CD_HEADER_SIZE) ||
+            readLE<uint32_t>(ptr) != CD_SIGNATURE)
+            return false;
+
+        size_t nameLen = readLE<uint16_t>(ptr + 28);
+        size_t extraLen = readLE<uint16_t>(ptr + 30);
+        size_t commentLen = readLE<uint16_t>(ptr + 32);
+        size_t recordLen = CD_HEADER_SIZE + nameLen + extraLen + commentLen;
+
+        if (static_cast<size_t>(end - ptr) < recordLen) return false;
+
+        std::string_view name(reinterpret_cast<const char *>(ptr + CD_HEADER_SIZE), nameLen);
+
+        if (name.find(needle) != std::string_view::npos) return true;
+
+        ptr += recordLen;
+    }
+
+    return false;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Scans the central directory of an in-memory ZIP archive for an entry name containing needle
+bool zipHasEntryContaining(const uint8_t *data, size_t size, std::string_view needle);
@@ -82,6 +82,9 @@ function applyButtonEventListeners() {
     const terminal = document.querySelector('.output-terminal-content');
 
     fetchButton.addEventListener('click', runAction);
+    document.getElementById('trace').addEventListener('click', showTrace);
+    document.getElementById('diagnostics').addEventListener('click', showDiagnostics);
+    document.getElementById('propstats').addEventListener('click', showPropStats);
     previewFpToggle.addEventListener('click', async () => {
         if (shellRunning) return;
         shellRunning = true;
@@ -191,6 +194,52 @@ function runAction() {
     });
 }
 
+/**
+ * Prints a file the companion writes for the WebUI, one terminal line per file line
+ * @param {string} path - The file to print
+ * @param {string} title - Printed before the file
+ * @param {string} emptyMessage - Printed instead when the file can't be read
+ * @returns {Promise<void>}
+ */
+async function showFile(path, title, emptyMessage) {
+    if (shellRunning) return;
+    shellRunning = true;
+    try {
+        const content = await exec(`cat ${path}`);
+        appendToOutput(`[+] ${title}`);
+        content.trim().split('\n').forEach(line => appendToOutput(line));
+    } catch (error) {
+        appendToOutput(`[!] ${emptyMessage}`);
+        console.error(`Failed to read ${path}:`, error);
+    }
+    appendToOutput("");
+    shellRunning = false;
+}
+
+// Function to display the startup trace of recent gms.unstable launches. The companion collects
+// a launch's trace when the next one starts.
+function showTrace() {
+    return showFile("/data/adb/modules/playintegrityfix/trace.txt",
+        "Startup trace of recent gms.unstable launches:",
+        "No startup trace yet, open an app that uses Play Integrity twice");
+}
+
+// Function to display what the companion found wrong in pif.json the last time it compiled it
+function showDiagnostics() {
+    return showFile("/data/adb/modules/playintegrityfix/diagnostics.txt",
+        "pif.json diagnostics:",
+        "No diagnostics yet, open an app that uses Play Integrity first");
+}
+
+// Function to display which properties the hook saw read, how often it spoofed them and how
+// long the reads took. They're only counted with DEBUG on in pif.json. Like the trace, it's
+// updated when the next launch starts.
+function showPropStats() {
+    return showFile("/data/adb/modules/playintegrityfix/propstats.txt",
+        "Property reads seen by the hook, most read first:",
+        "No property stats yet, set DEBUG in pif.json and open an app that uses Play Integrity twice");
+}
+
 /**
  * Simulate MD3 ripple animation
  * Usage: class="ripple-element" style="position: relative; overflow: hidden;"